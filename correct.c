@@ -0,0 +1,196 @@
+#include <stdlib.h>
+#include "correct.h"
+
+/* Marks a syndrome that is shared by more than one bit position. */
+#define AMBIGUOUS UINT64_MAX
+
+/* Returned when a syndrome isn't in the table. */
+#define MISSING (UINT64_MAX - 1)
+
+/* Longest message that a table can be built for. Its table takes about 5 GiB. */
+#define SYNDROMES_MAX_LEN ((uint64_t)1 << 24)
+
+//----------------------------------------
+
+/* Syndrome structures */
+
+/* An open addressing hash table. A syndrome is never 0, so 0 marks an empty slot. */
+typedef struct {
+    uint64_t syndrome;
+    uint64_t pos;
+} slot_t;
+
+/* Bit positions count from the end of the message. Position 8i + j is bit j
+   (the bit with the value 1 << j) of the i-th byte from the end. */
+struct crc_syndromes {
+    uint64_t bits;
+    bool double_bits;
+    uint64_t *syndromes; //Syndrome of each bit position.
+    uint64_t mask;       //Number of slots minus one.
+    slot_t *slots;
+};
+
+static uint64_t slot_index(crc_syndromes_t *syndromes, uint64_t syndrome) {
+    return (syndrome * 0x9e3779b97f4a7c15) >> 32 & syndromes->mask;
+}
+
+static void syndromes_insert(crc_syndromes_t *syndromes, uint64_t syndrome, uint64_t pos) {
+    uint64_t i = slot_index(syndromes, syndrome);
+
+    while(syndromes->slots[i].syndrome != 0 && syndromes->slots[i].syndrome != syndrome) {
+        i = (i + 1) & syndromes->mask;
+    }
+
+    //Short CRCs repeat their syndromes within a message. Those bits can't be located.
+    syndromes->slots[i].pos = syndromes->slots[i].syndrome == 0 ? pos : AMBIGUOUS;
+    syndromes->slots[i].syndrome = syndrome;
+}
+
+/* Return the position of the bit with the syndrome. */
+static uint64_t syndromes_find(crc_syndromes_t *syndromes, uint64_t syndrome) {
+    uint64_t i = slot_index(syndromes, syndrome);
+
+    while(syndromes->slots[i].syndrome != 0) {
+        if(syndromes->slots[i].syndrome == syndrome) {
+            return syndromes->slots[i].pos;
+        }
+        i = (i + 1) & syndromes->mask;
+    }
+
+    return MISSING;
+}
+
+//----------------------------------------
+
+/* Syndrome construction */
+
+/* The CRC is affine, so the CRCs of two messages of the same length differ by a
+   linear function of the messages' difference. Appending a zero byte to both
+   messages applies the same linear map to the difference of their CRCs, which is
+   how the syndrome of a bit moves one byte further from the end. */
+static uint64_t shift_byte(params_t *params, uint64_t syndrome) {
+    static const unsigned char zero = 0;
+    return crc_table(params, syndrome ^ params->init, &zero, 1) ^ crc_table(params, params->init, &zero, 1);
+}
+
+crc_syndromes_t *crc_syndromes_build(params_t *params, uint64_t max_len, bool double_bits) {
+    if(max_len > SYNDROMES_MAX_LEN) {
+        return NULL;
+    }
+
+    crc_syndromes_t *syndromes = (crc_syndromes_t*) calloc(1, sizeof(crc_syndromes_t));
+
+    if(syndromes == NULL) {
+        return NULL;
+    }
+
+    syndromes->bits = 8 * max_len;
+    syndromes->double_bits = double_bits;
+
+    uint64_t count = 1;
+    while(count < 2 * syndromes->bits) {
+        count <<= 1;
+    }
+
+    syndromes->mask = count - 1;
+    syndromes->slots = (slot_t*) calloc(count, sizeof(slot_t));
+    syndromes->syndromes = (uint64_t*) malloc((syndromes->bits ? syndromes->bits : 1) * sizeof(uint64_t));
+
+    if(syndromes->slots == NULL || syndromes->syndromes == NULL) {
+        crc_syndromes_free(syndromes);
+        return NULL;
+    }
+
+    //The syndromes of the bits of the last byte are found directly.
+    static const unsigned char zero = 0;
+    uint64_t crc_zero = crc_table(params, params->init, &zero, 1);
+
+    for(uint64_t pos = 0; pos < syndromes->bits; pos++) {
+        if(pos < 8) {
+            unsigned char bit = (unsigned char)(1 << pos);
+            syndromes->syndromes[pos] = crc_table(params, params->init, &bit, 1) ^ crc_zero;
+        } else {
+            syndromes->syndromes[pos] = shift_byte(params, syndromes->syndromes[pos - 8]);
+        }
+
+        syndromes_insert(syndromes, syndromes->syndromes[pos], pos);
+    }
+
+    return syndromes;
+}
+
+void crc_syndromes_free(crc_syndromes_t *syndromes) {
+    free(syndromes->syndromes);
+    free(syndromes->slots);
+    free(syndromes);
+}
+
+//----------------------------------------
+
+/* Error correction */
+
+static void flip_bit(unsigned char *buf, uint64_t len, uint64_t pos) {
+    buf[len - 1 - pos / 8] ^= (unsigned char)(1 << (pos % 8));
+}
+
+/* Find the pair of bits with the syndrome. Each pair is found once from each of
+   its bits, so any other pair makes the error ambiguous. */
+static bool find_pair(crc_syndromes_t *syndromes, uint64_t syndrome, uint64_t bits, uint64_t *pos, uint64_t *pos2) {
+    bool found = false;
+
+    for(uint64_t a = 0; a < bits; a++) {
+        uint64_t b = syndromes_find(syndromes, syndrome ^ syndromes->syndromes[a]);
+
+        if(b == AMBIGUOUS) {
+            return false;
+        }
+
+        if(b >= bits || b <= a) {
+            continue;
+        }
+
+        if(found) {
+            return false;
+        }
+
+        *pos = a;
+        *pos2 = b;
+        found = true;
+    }
+
+    return found;
+}
+
+int crc_correct(params_t *params, crc_syndromes_t *syndromes, unsigned char *buf, uint64_t len, uint64_t expected) {
+    uint64_t syndrome = crc_calc(params, params->init, buf, len) ^ expected;
+    uint64_t bits = 8 * len;
+
+    if(syndrome == 0) {
+        return 0;
+    }
+
+    if(bits > syndromes->bits) {
+        return -1;
+    }
+
+    uint64_t pos = syndromes_find(syndromes, syndrome);
+
+    if(pos == AMBIGUOUS) {
+        return -1;
+    }
+
+    if(pos < bits) {
+        flip_bit(buf, len, pos);
+        return 1;
+    }
+
+    uint64_t pos2;
+
+    if(syndromes->double_bits && find_pair(syndromes, syndrome, bits, &pos, &pos2)) {
+        flip_bit(buf, len, pos);
+        flip_bit(buf, len, pos2);
+        return 2;
+    }
+
+    return -1;
+}
@@ -0,0 +1,30 @@
+#ifndef CRC_CORRECT_H
+#define CRC_CORRECT_H
+
+#include "crc.h"
+
+/* Maps the syndrome of each single-bit error, the XOR of the received and the
+   computed CRCs, to the position of the bit. The syndrome only depends on the
+   distance of the bit from the end of the message, so one table serves every
+   message up to the length it was built for. */
+typedef struct crc_syndromes crc_syndromes_t;
+
+/* Build the syndromes of messages of up to max_len bytes. If double_bits is
+   true, crc_correct also searches for pairs of flipped bits. The table holds a
+   syndrome and a hash slot of 16 bytes for each bit, with at most half the slots
+   in use. That is 320 to 576 bytes per byte of max_len, or 320 MiB for 1 MiB.
+   Returns NULL if max_len is more than 16 MiB or the table couldn't be
+   allocated. */
+crc_syndromes_t DLL_EXPORT *crc_syndromes_build(params_t *params, uint64_t max_len, bool double_bits);
+
+/* Release a table returned by crc_syndromes_build. */
+void DLL_EXPORT crc_syndromes_free(crc_syndromes_t *syndromes);
+
+/* Check buf against its expected CRC and flip the bits that make it match. A
+   single-bit error is found with one lookup after computing the CRC, and a
+   double-bit error with one lookup per bit of buf. Returns the number of bits
+   that were flipped, or -1 if the error couldn't be located unambiguously, in
+   which case buf is unchanged. syndromes must be built with the same params. */
+int DLL_EXPORT crc_correct(params_t *params, crc_syndromes_t *syndromes, unsigned char *buf, uint64_t len, uint64_t expected);
+
+#endif
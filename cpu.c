@@ -8,6 +8,7 @@
 #include "cpu.h"
 
 bool cpu_enable_simd = false;
+bool cpu_enable_shuffle = false;
 
 #ifdef DISABLE_SIMD
 
@@ -19,7 +20,8 @@ void cpu_check_features() {}
 
 /* Check CPU features */
 
-//Check for availability of SSE4.2 and PCLMULQDQ intrinsics.
+//Check for availability of SSE4.2 and PCLMULQDQ intrinsics, and of SSSE3 for
+//the table lookups of the shuffle algorithm.
 #if defined(__x86_64__) || defined(_M_AMD64)
 
 #ifdef _MSC_VER
@@ -39,11 +41,14 @@ static void _cpu_check_features() {
 
     int x86_cpu_has_sse42 = abcd[2] & 0x100000;
     int x86_cpu_has_pclmulqdq = abcd[2] & 0x2;
+    int x86_cpu_has_ssse3 = abcd[2] & 0x200;
 
     cpu_enable_simd = x86_cpu_has_sse42 && x86_cpu_has_pclmulqdq;
+    cpu_enable_shuffle = x86_cpu_has_ssse3;
 }
 
-//Check for availability of the PMULL intrinsic.
+//Check for availability of the PMULL intrinsic. The table lookups of the shuffle
+//algorithm are part of the base NEON instruction set.
 #elif defined(__aarch64__) || defined(_M_ARM64)
 
 #ifdef __ANDROID__
@@ -60,6 +65,8 @@ static void _cpu_check_features() {
 #endif
 
 static void _cpu_check_features() {
+    cpu_enable_shuffle = true;
+
     #ifdef __ANDROID__
     cpu_enable_simd = android_getCpuFeatures() & ANDROID_CPU_ARM64_FEATURE_PMULL;
     #elif __linux__
@@ -17,6 +17,7 @@
 #endif
 
 extern bool DLL_EXPORT cpu_enable_simd;
+extern bool DLL_EXPORT cpu_enable_shuffle;
 void DLL_EXPORT cpu_check_features();
 
 #endif
\ No newline at end of file
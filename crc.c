@@ -1,31 +1,37 @@
 #include <stdio.h>
+#include <string.h>
 #include "crc.h"
+#include "thread.h"
 
 #ifndef DISABLE_SIMD
 #include "cpu.h"
 #include "intrinsics.h"
-
-#ifdef __GNUC__
-#ifdef __x86_64__
-#define TARGET_ATTRIBUTE __attribute__((target("sse4.1,pclmul")))
-#elif __aarch64__
-#define TARGET_ATTRIBUTE __attribute__((target("+aes")))
-#else
-#error "Unsupported Architecture. Compile on x86-64 or aarch64 or use DISABLE_SIMD."
-#endif
-#elif _MSC_VER
-#if defined(_M_AMD64) || defined(_M_ARM64)
-#define TARGET_ATTRIBUTE
-#else
-#error "Unsupported Architecture. Compile on x86-64 or aarch64 or use DISABLE_SIMD."
-#endif
-#else
-#error "Unsupported Compiler. Use GCC, Clang, or MSVC."
-#endif
 #endif
 
 //----------------------------------------
 
+/* Algorithm crossover lengths */
+
+/* The default shuffle_min is about where the shuffle algorithm overtakes the
+   table, since joining its chunks with the software multmodp costs about as
+   much as 700 bytes. */
+crc_tuning_t crc_tuning = {16, 512, 48, 1024};
+
+/* Read crc_tuning once per CRC, so that a single computation uses consistent
+   values while crc_autotune or crc_tuning_load replace them. Each field is read
+   atomically. A mix of old and new fields is valid, since each respects its
+   minimum. */
+static crc_tuning_t crc_tuning_get() {
+    crc_tuning_t tuning;
+    tuning.clmul_min = atomic_load64_relaxed(&crc_tuning.clmul_min);
+    tuning.align_min = atomic_load64_relaxed(&crc_tuning.align_min);
+    tuning.fold4_min = atomic_load64_relaxed(&crc_tuning.fold4_min);
+    tuning.shuffle_min = atomic_load64_relaxed(&crc_tuning.shuffle_min);
+    return tuning;
+}
+
+//----------------------------------------
+
 /* Static function definitions */
 
 static uint64_t reflect(uint64_t x, uint8_t w);
@@ -33,17 +39,31 @@ static uint64_t xndivp(params_t *params, uint64_t n);
 static uint64_t crc_initial(params_t *params, uint64_t crc);
 static uint64_t crc_final(params_t *params, uint64_t crc);
 static uint64_t crc_bytes(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+static crc_tuning_t crc_tuning_get();
+static uint64_t crc_update(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_update_tuned(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_skip_zeros(params_t *params, uint64_t crc, uint64_t len);
+static bool page_is_zero(unsigned char const *page);
+static uint64_t crc_sparse_region(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_hole(params_t *params, uint64_t crc, uint64_t len);
+static uint64_t crc_calc_holes(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *holes, uint64_t n, bool sparse);
 static uint64_t multmodp_sw(params_t *params, uint64_t a, uint64_t b);
 static uint64_t multmodp(params_t *params, uint64_t a, uint64_t b);
 static void crc_build_table(params_t *params);
 static void crc_build_combine_table(params_t *params);
+static void crc_build_uncombine_table(params_t *params);
+static uint64_t multpowers(params_t *params, uint64_t const *table, uint64_t len);
+static uint64_t combine_constant_cached(params_t *params, uint64_t len, uint64_t *last_len, uint64_t *last_xp);
 
 #ifndef DISABLE_SIMD
 static uint128_t fold(uint128_t x, uint128_t y, uint128_t k);
 static uint128_t clmul65(uint128_t a, uint128_t b);
 static uint64_t modp(params_t *params, uint128_t x);
-static uint64_t crc_clmul(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_clmul(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_clmul_padded(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len);
+static uint64_t crc_clmul_strided(params_t *params, uint64_t crc, unsigned char const *base, uint64_t elem_len, int64_t stride, uint64_t count);
 static uint64_t multmodp_hw(params_t *params, uint64_t a, uint64_t b);
+static uint64_t crc_shuffle(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
 #endif
 
 //----------------------------------------
@@ -151,14 +171,16 @@ static uint64_t xndivp(params_t *params, uint64_t n) {
    xorout is XORed with the CRC at the end of the calculation.
 
    k constants are used to fold the buffer (Intel paper p12).
-   They are equal x^n mod p with varied values for n.
+   They are equal x^n mod p with varied values for n. k1 to k4 fold by 512 and
+   128 bits, and k5 to k8 fold by 256 and 384 bits.
 
    u is the constant used for the Barret Reduction.
 
    table holds the values for the byte-by-byte (or Sarwate) algorithm.
    It's the result of computing the CRC for every possible input byte.
 
-   combine_table holds multiples of x^i mod p for combining CRCs. */
+   combine_table holds multiples of x^i mod p for combining CRCs, and
+   uncombine_table holds their inverses for separating them. */
 
 /* For using CLMUL in the reflected domain, the Intel paper offers three
    different solutions (Intel paper p18-20):
@@ -180,7 +202,10 @@ params_t crc_params(uint8_t width, uint64_t poly, uint64_t init, bool refin, boo
     cpu_check_features();
     #endif
 
+    /* Clear the padding and the unused parts of compact_table too, so that the
+       struct has the same bytes every time. It's copied into images and checksummed. */
     params_t params;
+    memset(&params, 0, sizeof(params));
     *error = 0;
 
     if(width == 0 || width > 64) {
@@ -217,15 +242,26 @@ params_t crc_params(uint8_t width, uint64_t poly, uint64_t init, bool refin, boo
     crc_build_table(&params);
 
     #ifndef DISABLE_SIMD
-    uint64_t xp = refin ? 1 : params.poly;               //x^64 mod p | x^63 mod p
-    params.k4 = crc_zeros(&params, xp, 128-64);          //x^128 mod p | x^127 mod p
-    params.k3 = crc_zeros(&params, params.k4, 192-128);  //x^192 mod p | x^191 mod p
-    params.k2 = crc_zeros(&params, params.k3, 512-192);  //x^512 mod p | x^511 mod p
-    params.k1 = crc_zeros(&params, params.k2, 576-512);  //x^576 mod p | x^575 mod p
     params.u = xndivp(&params, refin ? 127 : 128);       //x^128 / p | x^127 / p
     #endif
 
     crc_build_combine_table(&params);
+    crc_build_uncombine_table(&params);
+
+    #ifndef DISABLE_SIMD
+    /* The folding constants are products of the powers in combine_table.
+       Multiplying by x^64 mod p | x^63 mod p adds the 64 bits of the CRC. */
+    uint64_t *ct = params.combine_table;
+    uint64_t xp = refin ? 1 : params.poly;            //x^64 mod p | x^63 mod p
+    params.k4 = multmodp(&params, xp, ct[3]);         //x^128 mod p | x^127 mod p
+    params.k3 = multmodp(&params, xp, ct[4]);         //x^192 mod p | x^191 mod p
+    params.k5 = multmodp(&params, params.k4, ct[4]);  //x^256 mod p | x^255 mod p
+    params.k6 = multmodp(&params, params.k3, ct[4]);  //x^320 mod p | x^319 mod p
+    params.k7 = multmodp(&params, params.k4, ct[5]);  //x^384 mod p | x^383 mod p
+    params.k8 = multmodp(&params, params.k3, ct[5]);  //x^448 mod p | x^447 mod p
+    params.k2 = multmodp(&params, params.k7, ct[4]);  //x^512 mod p | x^511 mod p
+    params.k1 = multmodp(&params, xp, ct[6]);         //x^576 mod p | x^575 mod p
+    #endif
 
     char *data = "123456789";
     uint64_t crc = crc_table(&params, params.init, (unsigned char*) data, 9);
@@ -292,22 +328,45 @@ static uint64_t crc_final(params_t *params, uint64_t crc) {
 
 /* CRC calculation functions */
 
-/* Computes the 256 element table for the tabular algorithm. */
+/* Computes the 256 element table for the tabular algorithm. Only the entries
+   of the single bits are computed by shifting. The rest are found using the
+   linearity of the CRC: table[a ^ b] = table[a] ^ table[b]. */
 static void crc_build_table(params_t *params) {
-    for(uint16_t i = 0; i < 256; i++) {
-        uint64_t crc = i;
+    uint64_t crc = params->poly;
 
-        if(params->refin) {
-            for(uint8_t j = 0; j < 8; j++) {
-                crc = (crc >> 1) ^ (params->poly & and_mask(crc & 1));
-            }
-        } else {
-            crc <<= 56;
-            for(uint8_t j = 0; j < 8; j++) {
-                crc = (crc << 1) ^ (params->poly & and_mask(crc >> 63));
-            }
+    params->table[0] = 0;
+
+    if(params->refin) {
+        for(uint16_t i = 128; i > 0; i >>= 1) {
+            params->table[i] = crc;
+            crc = (crc >> 1) ^ (params->poly & and_mask(crc & 1));
+        }
+    } else {
+        for(uint16_t i = 1; i < 256; i <<= 1) {
+            params->table[i] = crc;
+            crc = (crc << 1) ^ (params->poly & and_mask(crc >> 63));
+        }
+    }
+
+    for(uint16_t i = 3; i < 256; i++) {
+        uint16_t low = i & -i;
+        if(i != low) {
+            params->table[i] = params->table[i ^ low] ^ params->table[low];
+        }
+    }
+
+    /* The reflected entries already fit in the width. The others are scaled to
+       the width of the compact table instead of 64 bits. */
+    for(uint16_t i = 0; i < 256; i++) {
+        uint64_t entry = params->table[i];
+
+        if(params->width <= 8) {
+            params->compact_table.u8[i] = (uint8_t)(params->refin ? entry : entry >> 56);
+        } else if(params->width <= 16) {
+            params->compact_table.u16[i] = (uint16_t)(params->refin ? entry : entry >> 48);
+        } else if(params->width <= 32) {
+            params->compact_table.u32[i] = (uint32_t)(params->refin ? entry : entry >> 32);
         }
-        params->table[i] = crc;
     }
 }
 
@@ -337,8 +396,68 @@ uint64_t crc_zeros(params_t *params, uint64_t crc, uint64_t n) {
     return crc;
 }
 
+/* Compute the CRC byte-by-byte using the compact tables. The CRC is moved from
+   the 64-bit domain to the width of the table and back, which is a shift if
+   refin is false. A smaller table leaves more of the L1 cache to the caller. */
+static uint64_t crc_bytes8(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    uint8_t const *table = params->compact_table.u8;
+    uint8_t c = (uint8_t)(params->refin ? crc : crc >> 56);
+
+    while(len--) {
+        c = table[c ^ *buf++];
+    }
+
+    return params->refin ? c : (uint64_t)c << 56;
+}
+
+static uint64_t crc_bytes16(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    uint16_t const *table = params->compact_table.u16;
+
+    if(params->refin) {
+        uint16_t c = (uint16_t)crc;
+        while(len--) {
+            c = (c >> 8) ^ table[(c ^ *buf++) & 0xff];
+        }
+        return c;
+
+    } else {
+        uint16_t c = (uint16_t)(crc >> 48);
+        while(len--) {
+            c = (uint16_t)(c << 8) ^ table[(c >> 8) ^ *buf++];
+        }
+        return (uint64_t)c << 48;
+    }
+}
+
+static uint64_t crc_bytes32(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    uint32_t const *table = params->compact_table.u32;
+
+    if(params->refin) {
+        uint32_t c = (uint32_t)crc;
+        while(len--) {
+            c = (c >> 8) ^ table[(c ^ *buf++) & 0xff];
+        }
+        return c;
+
+    } else {
+        uint32_t c = (uint32_t)(crc >> 32);
+        while(len--) {
+            c = (c << 8) ^ table[(c >> 24) ^ *buf++];
+        }
+        return (uint64_t)c << 32;
+    }
+}
+
 /* Compute the CRC byte-by-byte using the lookup table. */
 static uint64_t crc_bytes(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    if(params->width <= 8) {
+        return crc_bytes8(params, crc, buf, len);
+    } else if(params->width <= 16) {
+        return crc_bytes16(params, crc, buf, len);
+    } else if(params->width <= 32) {
+        return crc_bytes32(params, crc, buf, len);
+    }
+
     if(params->refin) {
         while(len--) {
             crc = (crc >> 8) ^ params->table[(crc ^ *buf++) & 0xff];
@@ -406,33 +525,187 @@ static uint64_t modp(params_t *params, uint128_t x) {
     }
 }
 
+/* Fold the 16 byte blocks of buf into x1, followed by the remaining bytes, and
+   multiply the result by x^64 for the Barrett Reduction. Shared by crc_clmul and
+   crc_clmul_padded once they have loaded the first block. */
+TARGET_ATTRIBUTE
+static ALWAYS_INLINE uint128_t fold_blocks_reflected(params_t *params, crc_tuning_t const *tuning, uint128_t x1, unsigned char const *buf, uint64_t len) {
+    //Data alignment: [ax^0 bx^1 ... cx^n]
+    const uint128_t ones = intrin_set(0xffffffffffffffff, 0xffffffffffffffff);
+    const uint128_t zero = intrin_set(0, 0);
+    uint128_t k2k1 = intrin_set(params->k2, params->k1);
+    uint128_t k4k3 = intrin_set(params->k4, params->k3);
+    uint128_t k5k6 = intrin_set(params->k5, params->k6);
+    uint128_t k7k8 = intrin_set(params->k7, params->k8);
+    uint128_t k0k4 = intrin_set(1, params->k4);
+    uint128_t x2, x3, x4;
+    uint128_t y1, y2, y3, y4;
+
+    if(len >= tuning->fold4_min) {
+        x2 = intrin_loadu_le(buf);
+        x3 = intrin_loadu_le(buf + 16);
+        x4 = intrin_loadu_le(buf + 32);
+
+        buf += 48;
+        len -= 48;
+
+        //Fold by 4.
+        while(len >= 64) {
+            y1 = intrin_loadu_le(buf);
+            y2 = intrin_loadu_le(buf + 16);
+            y3 = intrin_loadu_le(buf + 32);
+            y4 = intrin_loadu_le(buf + 48);
+
+            x1 = fold(x1, y1, k2k1);
+            x2 = fold(x2, y2, k2k1);
+            x3 = fold(x3, y3, k2k1);
+            x4 = fold(x4, y4, k2k1);
+
+            buf += 64;
+            len -= 64;
+        }
+
+        //Fold the remaining blocks into the oldest accumulator.
+        while(len >= 16) {
+            y1 = intrin_loadu_le(buf);
+            y1 = fold(x1, y1, k2k1);
+            x1 = x2;
+            x2 = x3;
+            x3 = x4;
+            x4 = y1;
+            buf += 16;
+            len -= 16;
+        }
+
+        //Fold to 128 bits.
+        x1 = fold(x1, fold(x2, fold(x3, x4, k4k3), k5k6), k7k8);
+    }
+
+    //Fold by 1.
+    while(len >= 16) {
+        y1 = intrin_loadu_le(buf);
+        x1 = fold(x1, y1, k4k3);
+        buf += 16;
+        len -= 16;
+    }
+
+    //Fold the remaining bytes.
+    if(len > 0) {
+        y1 = intrin_loadu_le(buf - (16 - len));
+        y1 = intrin_xor(intrin_shr(x1, len), intrin_and(y1, intrin_shl(ones, 16 - len)));
+        x1 = intrin_shl(x1, 16 - len);
+        x1 = fold(x1, y1, k4k3);
+    }
+
+    //Add 64 zeros.
+    return fold(x1, zero, k0k4);
+}
+
+TARGET_ATTRIBUTE
+static ALWAYS_INLINE uint128_t fold_blocks_nonreflected(params_t *params, crc_tuning_t const *tuning, uint128_t x1, unsigned char const *buf, uint64_t len) {
+    //Data alignment: [ax^n bx^(n-1) ... cx^0]
+    const uint128_t ones = intrin_set(0xffffffffffffffff, 0xffffffffffffffff);
+    const uint128_t zero = intrin_set(0, 0);
+    uint128_t k1k2 = intrin_set(params->k1, params->k2);
+    uint128_t k3k4 = intrin_set(params->k3, params->k4);
+    uint128_t k6k5 = intrin_set(params->k6, params->k5);
+    uint128_t k8k7 = intrin_set(params->k8, params->k7);
+    uint128_t k4k0 = intrin_set(params->k4, params->poly);
+    uint128_t x2, x3, x4;
+    uint128_t y1, y2, y3, y4;
+
+    if(len >= tuning->fold4_min) {
+        x2 = intrin_loadu_bg(buf);
+        x3 = intrin_loadu_bg(buf + 16);
+        x4 = intrin_loadu_bg(buf + 32);
+
+        buf += 48;
+        len -= 48;
+
+        //Fold by 4.
+        while(len >= 64) {
+            y1 = intrin_loadu_bg(buf);
+            y2 = intrin_loadu_bg(buf + 16);
+            y3 = intrin_loadu_bg(buf + 32);
+            y4 = intrin_loadu_bg(buf + 48);
+
+            x1 = fold(x1, y1, k1k2);
+            x2 = fold(x2, y2, k1k2);
+            x3 = fold(x3, y3, k1k2);
+            x4 = fold(x4, y4, k1k2);
+
+            buf += 64;
+            len -= 64;
+        }
+
+        //Fold the remaining blocks into the oldest accumulator.
+        while(len >= 16) {
+            y1 = intrin_loadu_bg(buf);
+            y1 = fold(x1, y1, k1k2);
+            x1 = x2;
+            x2 = x3;
+            x3 = x4;
+            x4 = y1;
+            buf += 16;
+            len -= 16;
+        }
+
+        //Fold to 128 bits.
+        x1 = fold(x1, fold(x2, fold(x3, x4, k3k4), k6k5), k8k7);
+    }
+
+    //Fold by 1.
+    while(len >= 16) {
+        y1 = intrin_loadu_bg(buf);
+        x1 = fold(x1, y1, k3k4);
+        buf += 16;
+        len -= 16;
+    }
+
+    //Fold the remaining bytes.
+    if(len > 0) {
+        y1 = intrin_loadu_bg(buf - (16 - len));
+        y1 = intrin_xor(intrin_shl(x1, len), intrin_and(y1, intrin_shr(ones, 16 - len)));
+        x1 = intrin_shr(x1, 16 - len);
+        x1 = fold(x1, y1, k3k4);
+    }
+
+    //Add 64 zeros.
+    return fold(x1, zero, k4k0);
+}
+
 /* Hardware accelerated algorithm based on the version used in Chromium.
 
    The folding method (Intel paper p11-13) is used to reduce the buffer to a smaller
    buffer "congruent (modulo the polynomial) to the original one" (Intel paper p7).
    The CRC of the folded buffer is then computed using Barret Reduction.
 
+   Buffers shorter than tuning->align_min are read with unaligned loads.
+   Aligning them costs an extra fold, which is a large part of the work for
+   short buffers.
+
+   After the fold by 4 loop, the remaining 16 byte blocks are folded into the
+   oldest accumulator, and the four accumulators are reduced in parallel using
+   constants for their distance from the last one (x^384, x^256, x^128). This
+   avoids a chain of dependent folds for buffers of 64 bytes or more.
+
    It should be possible to extend this algorithm to use the 256 and 512 bit
    variants of CLMUL, using a similar approach to the one shown here. */
 
 TARGET_ATTRIBUTE
-static uint64_t crc_clmul(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
-    uint64_t offset = (uintptr_t)buf & 0xf;
-    uint64_t rem = 16 - offset;
+static uint64_t crc_clmul(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    uint64_t offset = len >= tuning->align_min ? (uintptr_t)buf & 0xf : 0;
+    uint64_t rem = offset ? 16 - offset : 0;
 
     if(len >= 16 + rem) {
         const uint128_t ones = intrin_set(0xffffffffffffffff, 0xffffffffffffffff);
-        const uint128_t zero = intrin_set(0, 0);
-        uint128_t x1, x2, x3, x4;
-        uint128_t y1, y2, y3, y4;
+        uint128_t x1, y1;
 
         if(params->refin) {
             //Reflected algorithm
             //Data alignment: [ax^0 bx^1 ... cx^n]
             uint128_t c = intrin_set(0, crc);
-            uint128_t k2k1 = intrin_set(params->k2, params->k1);
             uint128_t k4k3 = intrin_set(params->k4, params->k3);
-            uint128_t k5k4 = intrin_set(1, params->k4);
 
             //xor with the init.
             x1 = intrin_loadu_le(buf);
@@ -448,68 +721,19 @@ static uint64_t crc_clmul(params_t *params, uint64_t crc, unsigned char const *b
                 x1 = fold(x1, y1, k4k3);
                 buf += rem;
                 len -= rem;
-            }
-
-            #ifdef DEBUG
-            assert(((uintptr_t)buf & 0xf) == 0);
-            #endif
-
-            if(len >= 48) {
-                x2 = intrin_load_le(buf);
-                x3 = intrin_load_le(buf + 16);
-                x4 = intrin_load_le(buf + 32);
-
-                buf += 48;
-                len -= 48;
-
-                //Fold by 4.
-                while(len >= 64) {
-                    y1 = intrin_load_le(buf);
-                    y2 = intrin_load_le(buf + 16);
-                    y3 = intrin_load_le(buf + 32);
-                    y4 = intrin_load_le(buf + 48);
-
-                    x1 = fold(x1, y1, k2k1);
-                    x2 = fold(x2, y2, k2k1);
-                    x3 = fold(x3, y3, k2k1);
-                    x4 = fold(x4, y4, k2k1);
-
-                    buf += 64;
-                    len -= 64;
-                }
-
-                //Fold to 128 bits.
-                x1 = fold(x1, x2, k4k3);
-                x1 = fold(x1, x3, k4k3);
-                x1 = fold(x1, x4, k4k3);
-            }
-
-            //Fold by 1.
-            while(len >= 16) {
-                y1 = intrin_load_le(buf);
-                x1 = fold(x1, y1, k4k3);
-                buf += 16;
-                len -= 16;
-            }
 
-            //Fold the remaining bytes.
-            if(len > 0) {
-                y1 = intrin_loadu_le(buf - (16 - len));
-                y1 = intrin_xor(intrin_shr(x1, len), intrin_and(y1, intrin_shl(ones, 16 - len)));
-                x1 = intrin_shl(x1, 16 - len);
-                x1 = fold(x1, y1, k4k3);
+                #ifdef DEBUG
+                assert(((uintptr_t)buf & 0xf) == 0);
+                #endif
             }
 
-            //Add 64 zeros.
-            x1 = fold(x1, zero, k5k4);
+            x1 = fold_blocks_reflected(params, tuning, x1, buf, len);
 
         } else {
             //Non-reflected algorithm
             //Data alignment: [ax^n bx^(n-1) ... cx^0]
             uint128_t c = intrin_set(crc, 0);
-            uint128_t k1k2 = intrin_set(params->k1, params->k2);
             uint128_t k3k4 = intrin_set(params->k3, params->k4);
-            uint128_t k4k5 = intrin_set(params->k4, params->poly);
 
             //xor with the init.
             x1 = intrin_loadu_bg(buf);
@@ -525,82 +749,399 @@ static uint64_t crc_clmul(params_t *params, uint64_t crc, unsigned char const *b
                 x1 = fold(x1, y1, k3k4);
                 buf += rem;
                 len -= rem;
-            }
 
-            #ifdef DEBUG
-            assert(((uintptr_t)buf & 0xf) == 0);
-            #endif
-
-            if(len >= 48) {
-                x2 = intrin_load_bg(buf);
-                x3 = intrin_load_bg(buf + 16);
-                x4 = intrin_load_bg(buf + 32);
-
-                buf += 48;
-                len -= 48;
-
-                //Fold by 4.
-                while(len >= 64) {
-                    y1 = intrin_load_bg(buf);
-                    y2 = intrin_load_bg(buf + 16);
-                    y3 = intrin_load_bg(buf + 32);
-                    y4 = intrin_load_bg(buf + 48);
-
-                    x1 = fold(x1, y1, k1k2);
-                    x2 = fold(x2, y2, k1k2);
-                    x3 = fold(x3, y3, k1k2);
-                    x4 = fold(x4, y4, k1k2);
-
-                    buf += 64;
-                    len -= 64;
-                }
-
-                //Fold to 128 bits.
-                x1 = fold(x1, x2, k3k4);
-                x1 = fold(x1, x3, k3k4);
-                x1 = fold(x1, x4, k3k4);
+                #ifdef DEBUG
+                assert(((uintptr_t)buf & 0xf) == 0);
+                #endif
             }
 
-            //Fold by 1.
-            while(len >= 16) {
-                y1 = intrin_load_bg(buf);
-                x1 = fold(x1, y1, k3k4);
-                buf += 16;
-                len -= 16;
+            x1 = fold_blocks_nonreflected(params, tuning, x1, buf, len);
+        }
+
+        return modp(params, x1);
+    }
+
+    return crc_bytes(params, crc, buf, len);
+}
+
+/* Selects the last n bytes of a block when loaded from padded_mask + n. */
+static const unsigned char padded_mask[32] = {
+    0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff
+};
+
+/* Variant of crc_clmul for buffers with readable bytes before them. The first
+   block is loaded from before the buffer and the bytes that precede the buffer
+   are masked to zeros, which leaves only whole blocks that end at the end of the
+   buffer. This replaces the alignment fold and the folding of the remaining
+   bytes, which both need shifts by a variable number of bytes.
+
+   The CRC is added to the first 8 bytes of the buffer, which may straddle the
+   first two blocks. It's split between them with scalar shifts. len must be at
+   least 8. */
+TARGET_ATTRIBUTE
+static uint64_t crc_clmul_padded(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    //Bytes of the buffer in the first block.
+    uint64_t head = len % 16 ? len % 16 : 16;
+    uint64_t bits = 8 * head;
+    uint128_t x1, y1;
+
+    if(params->refin) {
+        //The CRC starts at bit 128 - bits of the first block.
+        uint128_t k4k3 = intrin_set(params->k4, params->k3);
+        uint128_t c1, c2;
+
+        if(head >= 8) {
+            c1 = intrin_set(bits < 128 ? crc >> (bits - 64) : 0, bits > 64 ? crc << (128 - bits) : 0);
+            c2 = intrin_set(0, 0);
+        } else {
+            c1 = intrin_set(crc << (64 - bits), 0);
+            c2 = intrin_set(0, crc >> bits);
+        }
+
+        x1 = intrin_and(intrin_loadu_le(buf - (16 - head)), intrin_loadu_le(padded_mask + head));
+        x1 = intrin_xor(x1, c1);
+        buf += head;
+        len -= head;
+
+        if(head < 8) {
+            y1 = intrin_xor(intrin_loadu_le(buf), c2);
+            x1 = fold(x1, y1, k4k3);
+            buf += 16;
+            len -= 16;
+        }
+
+        x1 = fold_blocks_reflected(params, tuning, x1, buf, len);
+
+    } else {
+        //The top of the CRC is at bit bits - 1 of the first block.
+        uint128_t k3k4 = intrin_set(params->k3, params->k4);
+        uint128_t c1, c2;
+
+        if(head >= 8) {
+            c1 = intrin_set(bits > 64 ? crc >> (128 - bits) : 0, bits < 128 ? crc << (bits - 64) : 0);
+            c2 = intrin_set(0, 0);
+        } else {
+            c1 = intrin_set(0, crc >> (64 - bits));
+            c2 = intrin_set(crc << bits, 0);
+        }
+
+        x1 = intrin_and(intrin_loadu_bg(buf - (16 - head)), intrin_loadu_bg(padded_mask + head));
+        x1 = intrin_xor(x1, c1);
+        buf += head;
+        len -= head;
+
+        if(head < 8) {
+            y1 = intrin_xor(intrin_loadu_bg(buf), c2);
+            x1 = fold(x1, y1, k3k4);
+            buf += 16;
+            len -= 16;
+        }
+
+        x1 = fold_blocks_nonreflected(params, tuning, x1, buf, len);
+    }
+
+    return modp(params, x1);
+}
+
+/* Moves n bytes forward in a strided buffer. n doesn't cross the end of an element. */
+static ALWAYS_INLINE void strided_advance(unsigned char const **elem, uint64_t *pos, uint64_t elem_len, int64_t stride, uint64_t n) {
+    *pos += n;
+
+    if(*pos == elem_len) {
+        *elem += stride;
+        *pos = 0;
+    }
+}
+
+/* Returns the next 16 byte block of a strided buffer and moves past it. */
+static ALWAYS_INLINE unsigned char const *strided_next(unsigned char const **elem, uint64_t *pos, uint64_t elem_len, int64_t stride) {
+    unsigned char const *block = *elem + *pos;
+    strided_advance(elem, pos, elem_len, stride, 16);
+    return block;
+}
+
+/* Variant of crc_clmul for count elements of elem_len bytes, stride bytes apart.
+   The elements are a stream of 16 byte blocks, since elem_len is a multiple of
+   16, so the four accumulators are carried across the element boundaries
+   instead of reducing the CRC of each element. Runs of 64 bytes inside an
+   element are folded by 4, and the other blocks are folded into the oldest
+   accumulator like the remaining blocks in fold_blocks_*, which works at any
+   position in the stream. There must be at least 4 blocks. */
+TARGET_ATTRIBUTE
+static uint64_t crc_clmul_strided(params_t *params, uint64_t crc, unsigned char const *base, uint64_t elem_len, int64_t stride, uint64_t count) {
+    const uint128_t zero = intrin_set(0, 0);
+    uint64_t blocks = count * (elem_len / 16);
+    uint64_t pos = 0;
+    uint128_t x1, x2, x3, x4, y1;
+
+    if(params->refin) {
+        //Data alignment: [ax^0 bx^1 ... cx^n]
+        uint128_t k2k1 = intrin_set(params->k2, params->k1);
+        uint128_t k4k3 = intrin_set(params->k4, params->k3);
+        uint128_t k5k6 = intrin_set(params->k5, params->k6);
+        uint128_t k7k8 = intrin_set(params->k7, params->k8);
+        uint128_t k0k4 = intrin_set(1, params->k4);
+
+        x1 = intrin_xor(intrin_loadu_le(strided_next(&base, &pos, elem_len, stride)), intrin_set(0, crc));
+        x2 = intrin_loadu_le(strided_next(&base, &pos, elem_len, stride));
+        x3 = intrin_loadu_le(strided_next(&base, &pos, elem_len, stride));
+        x4 = intrin_loadu_le(strided_next(&base, &pos, elem_len, stride));
+
+        for(uint64_t i = 4; i < blocks; i++) {
+            //Fold by 4 inside an element.
+            if(pos + 64 <= elem_len && i + 4 <= blocks) {
+                x1 = fold(x1, intrin_loadu_le(base + pos), k2k1);
+                x2 = fold(x2, intrin_loadu_le(base + pos + 16), k2k1);
+                x3 = fold(x3, intrin_loadu_le(base + pos + 32), k2k1);
+                x4 = fold(x4, intrin_loadu_le(base + pos + 48), k2k1);
+                strided_advance(&base, &pos, elem_len, stride, 64);
+                i += 3;
+                continue;
             }
 
-            //Fold the remaining bytes.
-            if(len > 0) {
-                y1 = intrin_loadu_bg(buf - (16 - len));
-                y1 = intrin_xor(intrin_shl(x1, len), intrin_and(y1, intrin_shr(ones, 16 - len)));
-                x1 = intrin_shr(x1, 16 - len);
-                x1 = fold(x1, y1, k3k4);
+            y1 = intrin_loadu_le(strided_next(&base, &pos, elem_len, stride));
+            y1 = fold(x1, y1, k2k1);
+            x1 = x2;
+            x2 = x3;
+            x3 = x4;
+            x4 = y1;
+        }
+
+        x1 = fold(x1, fold(x2, fold(x3, x4, k4k3), k5k6), k7k8);
+        x1 = fold(x1, zero, k0k4);
+
+    } else {
+        //Data alignment: [ax^n bx^(n-1) ... cx^0]
+        uint128_t k1k2 = intrin_set(params->k1, params->k2);
+        uint128_t k3k4 = intrin_set(params->k3, params->k4);
+        uint128_t k6k5 = intrin_set(params->k6, params->k5);
+        uint128_t k8k7 = intrin_set(params->k8, params->k7);
+        uint128_t k4k0 = intrin_set(params->k4, params->poly);
+
+        x1 = intrin_xor(intrin_loadu_bg(strided_next(&base, &pos, elem_len, stride)), intrin_set(crc, 0));
+        x2 = intrin_loadu_bg(strided_next(&base, &pos, elem_len, stride));
+        x3 = intrin_loadu_bg(strided_next(&base, &pos, elem_len, stride));
+        x4 = intrin_loadu_bg(strided_next(&base, &pos, elem_len, stride));
+
+        for(uint64_t i = 4; i < blocks; i++) {
+            //Fold by 4 inside an element.
+            if(pos + 64 <= elem_len && i + 4 <= blocks) {
+                x1 = fold(x1, intrin_loadu_bg(base + pos), k1k2);
+                x2 = fold(x2, intrin_loadu_bg(base + pos + 16), k1k2);
+                x3 = fold(x3, intrin_loadu_bg(base + pos + 32), k1k2);
+                x4 = fold(x4, intrin_loadu_bg(base + pos + 48), k1k2);
+                strided_advance(&base, &pos, elem_len, stride, 64);
+                i += 3;
+                continue;
             }
 
-            //Add 64 zeros.
-            x1 = fold(x1, zero, k4k5);
+            y1 = intrin_loadu_bg(strided_next(&base, &pos, elem_len, stride));
+            y1 = fold(x1, y1, k1k2);
+            x1 = x2;
+            x2 = x3;
+            x3 = x4;
+            x4 = y1;
         }
 
-        return modp(params, x1);
+        x1 = fold(x1, fold(x2, fold(x3, x4, k3k4), k6k5), k8k7);
+        x1 = fold(x1, zero, k4k0);
     }
 
-    return crc_bytes(params, crc, buf, len);
+    return modp(params, x1);
 }
 #endif
 
+//----------------------------------------
+
+/* Shuffle-based CRC for CPUs without CLMUL */
+
+#ifndef DISABLE_SIMD
+/* Number of chunks computed in parallel by crc_shuffle. One per byte of a vector. */
+#define SHUFFLE_LANES 16
+
+/* Advance the CRCs of the 16 lanes over the next 16 bytes of their chunks.
+
+   The CRCs are stored in byte-planes: state[p] holds byte p of the CRC of each
+   lane, where byte 0 is the one that is XORed with the incoming byte. Shifting
+   the CRCs by 8 bits moves each plane to the previous one. The table entry of
+   the index is the sum of the entries of its two nibbles, each of which is a
+   lookup in a 16 byte table per plane:
+
+   table[i] = table[i & 0x0f] ^ table[i & 0xf0]
+
+   planes is a constant for each of the callers, so that the compiler keeps the
+   state and the tables in registers. */
+SHUFFLE_TARGET_ATTRIBUTE
+static ALWAYS_INLINE void shuffle_block(uint128_t *state, uint128_t const *lo_tables, uint128_t const *hi_tables,
+                                        unsigned char const *buf, uint64_t chunk, const uint8_t planes) {
+    uint128_t x[SHUFFLE_LANES], y[SHUFFLE_LANES];
+
+    for(uint8_t i = 0; i < SHUFFLE_LANES; i++) {
+        x[i] = intrin_loadu_le(buf + i * chunk);
+    }
+
+    //Transpose the 16x16 block, so that x[t] holds byte t of each lane.
+    for(uint8_t stage = 0; stage < 4; stage++) {
+        for(uint8_t i = 0; i < SHUFFLE_LANES / 2; i++) {
+            y[2*i] = intrin_unpacklo_8(x[i], x[i + 8]);
+            y[2*i + 1] = intrin_unpackhi_8(x[i], x[i + 8]);
+        }
+        for(uint8_t i = 0; i < SHUFFLE_LANES; i++) {
+            x[i] = y[i];
+        }
+    }
+
+    for(uint8_t t = 0; t < 16; t++) {
+        uint128_t index = intrin_xor(state[0], x[t]);
+        uint128_t lo = intrin_nibble_lo(index);
+        uint128_t hi = intrin_nibble_hi(index);
+
+        for(uint8_t p = 0; p < planes - 1; p++) {
+            state[p] = intrin_tri_xor(state[p + 1], intrin_lookup(lo_tables[p], lo), intrin_lookup(hi_tables[p], hi));
+        }
+        state[planes - 1] = intrin_xor(intrin_lookup(lo_tables[planes - 1], lo), intrin_lookup(hi_tables[planes - 1], hi));
+    }
+}
+
+SHUFFLE_TARGET_ATTRIBUTE
+static void shuffle_chunks(uint128_t *state, uint128_t const *lo_tables, uint128_t const *hi_tables,
+                           unsigned char const *buf, uint64_t chunk, const uint8_t planes) {
+    for(uint64_t i = 0; i < chunk; i += 16) {
+        shuffle_block(state, lo_tables, hi_tables, buf + i, chunk, planes);
+    }
+}
+
+/* Split the buffer into 16 chunks whose CRCs are computed in parallel with
+   nibble table lookups in the lanes of a vector, then joined with multmodp.
+   Only needs SSSE3 (or NEON), for CPUs that lack CLMUL. The number of planes
+   is rounded up to 1, 2, 4 or 8. The extra planes hold zeros in both domains. */
+SHUFFLE_TARGET_ATTRIBUTE
+static uint64_t crc_shuffle(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    uint64_t chunk = len / (SHUFFLE_LANES * 16) * 16;
+    uint8_t planes = params->width <= 8 ? 1 : params->width <= 16 ? 2 : params->width <= 32 ? 4 : 8;
+
+    unsigned char ALIGN_ARRAY bytes[3][8][16] = {{{0}}};
+    uint128_t lo_tables[8], hi_tables[8], state[8];
+
+    //Position of byte p of the CRC in the 64-bit value.
+    uint8_t shifts[8];
+    for(uint8_t p = 0; p < 8; p++) {
+        shifts[p] = params->refin ? 8 * p : 56 - 8 * p;
+    }
+
+    //The first lane continues from crc and the rest start from 0.
+    for(uint8_t p = 0; p < planes; p++) {
+        for(uint8_t n = 0; n < 16; n++) {
+            bytes[0][p][n] = (unsigned char)(params->table[n] >> shifts[p]);
+            bytes[1][p][n] = (unsigned char)(params->table[n << 4] >> shifts[p]);
+        }
+        bytes[2][p][0] = (unsigned char)(crc >> shifts[p]);
+
+        lo_tables[p] = intrin_loadu_le(bytes[0][p]);
+        hi_tables[p] = intrin_loadu_le(bytes[1][p]);
+        state[p] = intrin_loadu_le(bytes[2][p]);
+    }
+
+    switch(planes) {
+        case 1: shuffle_chunks(state, lo_tables, hi_tables, buf, chunk, 1); break;
+        case 2: shuffle_chunks(state, lo_tables, hi_tables, buf, chunk, 2); break;
+        case 4: shuffle_chunks(state, lo_tables, hi_tables, buf, chunk, 4); break;
+        default: shuffle_chunks(state, lo_tables, hi_tables, buf, chunk, 8); break;
+    }
+
+    for(uint8_t p = 0; p < planes; p++) {
+        intrin_storeu_le(bytes[2][p], state[p]);
+    }
+
+    //Join the CRCs of the lanes. The lanes after the first start from 0, so
+    //joining them doesn't involve the initial value.
+    uint64_t xp = crc_combine_constant(params, chunk);
+    crc = 0;
+
+    for(uint8_t i = 0; i < SHUFFLE_LANES; i++) {
+        uint64_t lane = 0;
+        for(uint8_t p = 0; p < planes; p++) {
+            lane |= (uint64_t)bytes[2][p][i] << shifts[p];
+        }
+        crc = multmodp(params, crc, xp) ^ lane;
+    }
+
+    return crc_bytes(params, crc, buf + SHUFFLE_LANES * chunk, len - SHUFFLE_LANES * chunk);
+}
+#endif
+
+//----------------------------------------
+
+/* Selects the algorithm used to compute the CRC based on the availability of
+   hardware intrinsics and the length of the buffer. The CRC is passed and
+   returned in the form produced by crc_initial. */
+static uint64_t crc_update_tuned(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    #ifndef DISABLE_SIMD
+    if(cpu_enable_simd && len >= tuning->clmul_min) {
+        return crc_clmul(params, tuning, crc, buf, len);
+    } else if(cpu_enable_shuffle && len >= tuning->shuffle_min) {
+        return crc_shuffle(params, crc, buf, len);
+    } else {
+        return crc_bytes(params, crc, buf, len);
+    }
+    #else
+    (void)tuning;
+    return crc_bytes(params, crc, buf, len);
+    #endif
+}
+
+/* crc_update_tuned with the current crc_tuning. */
+static uint64_t crc_update(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    crc_tuning_t tuning = crc_tuning_get();
+    return crc_update_tuned(params, &tuning, crc, buf, len);
+}
+
 /* SIMD implementation of CRC with software fallback. */
 uint64_t crc_calc(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
     crc = crc_initial(params, crc);
+    crc = crc_update(params, crc, buf, len);
+    return crc_final(params, crc);
+}
+
+uint64_t crc_calc_tuned(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    crc = crc_initial(params, crc);
+    crc = crc_update_tuned(params, tuning, crc, buf, len);
+    return crc_final(params, crc);
+}
+
+uint64_t crc_calc_padded(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    crc = crc_initial(params, crc);
 
     #ifndef DISABLE_SIMD
-    if(cpu_enable_simd) {
-        crc = crc_clmul(params, crc, buf, len);
+    if(cpu_enable_simd && len >= 8) {
+        crc_tuning_t tuning = crc_tuning_get();
+        crc = crc_clmul_padded(params, &tuning, crc, buf, len);
     } else {
-        crc = crc_bytes(params, crc, buf, len);
+        crc = crc_update(params, crc, buf, len);
     }
+    #else
+    crc = crc_update(params, crc, buf, len);
+    #endif
 
+    return crc_final(params, crc);
+}
+
+uint64_t crc_calc_strided(params_t *params, uint64_t crc, unsigned char const *base, uint64_t elem_len, int64_t stride, uint64_t count) {
+    crc = crc_initial(params, crc);
+
+    #ifndef DISABLE_SIMD
+    if(cpu_enable_simd && elem_len % 16 == 0 && elem_len / 16 * count >= 4) {
+        crc = crc_clmul_strided(params, crc, base, elem_len, stride, count);
+    } else {
+        for(uint64_t i = 0; i < count; i++) {
+            crc = crc_update(params, crc, base + (int64_t)i * stride, elem_len);
+        }
+    }
     #else
-    crc = crc_bytes(params, crc, buf, len);
+    for(uint64_t i = 0; i < count; i++) {
+        crc = crc_update(params, crc, base + (int64_t)i * stride, elem_len);
+    }
     #endif
 
     return crc_final(params, crc);
@@ -610,29 +1151,60 @@ uint64_t crc_calc(params_t *params, uint64_t crc, unsigned char const *buf, uint
 
 /* CRC combine functions */
 
-/* Adler's multmodp. Computes (a * b) mod p.
-   a*b mod p = sum(b * a[i] * x*i  mod p) for i = 0...63 */
+/* Computes (a * b) mod p without CLMUL. Adler's multmodp adds b * x^i mod p
+   for each bit of a, one bit at a time:
+   a*b mod p = sum(b * a[i] * x*i  mod p) for i = 0...63
+   This version multiplies by 4 bits of a at a time using the products of b with
+   every polynomial of degree < 4. The 128-bit product is accumulated without
+   reduction, and its high half is reduced at the end with the CRC table. */
 static uint64_t multmodp_sw(params_t *params, uint64_t a, uint64_t b) {
-    uint64_t prod;
+    uint64_t lo[16], hi[16];
+    uint64_t prod_lo = 0, prod_hi = 0;
 
+    //The bits of b * x^i that overflow the low half go to the high half.
+    lo[0] = hi[0] = 0;
+
+    for(uint8_t i = 0; i < 4; i++) {
+        uint8_t j = params->refin ? 8 >> i : 1 << i;
+        lo[j] = params->refin ? b >> i : b << i;
+        hi[j] = i == 0 ? 0 : params->refin ? b << (64 - i) : b >> (64 - i);
+    }
+
+    for(uint8_t i = 3; i < 16; i++) {
+        uint8_t low = i & -i;
+        if(i != low) {
+            lo[i] = lo[i ^ low] ^ lo[low];
+            hi[i] = hi[i ^ low] ^ hi[low];
+        }
+    }
+
+    //Horner's method over the 4-bit digits of a, starting from the highest powers.
     if(params->refin) {
-        prod = b & and_mask(a >> 63);
-        while(a) {
-            a <<= 1;
-            b = (b >> 1) ^ (params->poly & and_mask(b & 1));
-            prod ^= b & and_mask(a >> 63);
+        for(uint8_t i = 0; i < 16; i++) {
+            uint8_t digit = a & 0xf;
+            prod_hi = (prod_hi >> 4) ^ (prod_lo << 60) ^ hi[digit];
+            prod_lo = (prod_lo >> 4) ^ lo[digit];
+            a >>= 4;
+        }
+
+        for(uint8_t i = 0; i < 8; i++) {
+            prod_hi = (prod_hi >> 8) ^ params->table[prod_hi & 0xff];
         }
 
     } else {
-        prod = b & and_mask(a & 1);
-        while(a) {
-            a >>= 1;
-            b = (b << 1) ^ (params->poly & and_mask(b >> 63));
-            prod ^= b & and_mask(a & 1);
+        for(uint8_t i = 0; i < 16; i++) {
+            uint8_t digit = a >> 60;
+            prod_hi = (prod_hi << 4) ^ (prod_lo >> 60) ^ hi[digit];
+            prod_lo = (prod_lo << 4) ^ lo[digit];
+            a <<= 4;
+        }
+
+        for(uint8_t i = 0; i < 8; i++) {
+            prod_hi = (prod_hi << 8) ^ params->table[prod_hi >> 56];
         }
     }
 
-    return prod;
+    return prod_lo ^ prod_hi;
 }
 
 /* Hardware version of multmodp. Multiplies a and b using the CLMUL intrinsic
@@ -685,8 +1257,33 @@ static void crc_build_combine_table(params_t *params) {
     }
 }
 
-/* Multiplies the various x^2^i mod p factors to get x^8n mod p. */
-uint64_t crc_combine_constant(params_t *params, uint64_t len) {
+/* Fills uncombine_table with values of x^-(8*2^i) mod p, the inverses of the
+   values in combine_table. p has a constant term, so x^-1 mod p is p / x
+   without the remainder, plus the leading term x^w / x. */
+static void crc_build_uncombine_table(params_t *params) {
+    uint8_t w = params->width;
+    uint64_t poly = params->refin ? reflect(params->poly, w) : params->poly >> (64 - w);
+    uint64_t inv = (poly >> 1) | ((uint64_t)1 << (w - 1)); //x^-1 mod p
+
+    //Both domains represent the powers of x that are less than x^w the same way as combine_table.
+    if(params->refin) {
+        inv = reflect(inv, 64);
+    }
+
+    for(uint8_t i = 0; i < 3; i++) {
+        inv = multmodp(params, inv, inv);
+    }
+
+    params->uncombine_table[0] = inv; //x^-8 mod p
+    for(uint8_t i = 1; i < 64; i++) {
+        inv = multmodp(params, inv, inv); //x^-2^(i+3) mod p
+        params->uncombine_table[i] = inv;
+    }
+}
+
+/* Multiplies the factors in table that make up 8n, where table[i] holds
+   x^(8*2^i) mod p or its inverse. */
+static uint64_t multpowers(params_t *params, uint64_t const *table, uint64_t len) {
     if(len == 0) {
         return params->refin ? (uint64_t)1 << 63 : 1;
     }
@@ -699,19 +1296,29 @@ uint64_t crc_combine_constant(params_t *params, uint64_t len) {
         i++;
     }
 
-    xp = params->combine_table[i];
+    xp = table[i];
 
     while(len) {
         len >>= 1;
         i++;
         if(len & 1) {
-            xp = multmodp(params, xp, params->combine_table[i]);
+            xp = multmodp(params, xp, table[i]);
         }
     }
 
     return xp;
 }
 
+/* Multiplies the various x^2^i mod p factors to get x^8n mod p. */
+uint64_t crc_combine_constant(params_t *params, uint64_t len) {
+    return multpowers(params, params->combine_table, len);
+}
+
+/* Multiplies the various x^-2^i mod p factors to get x^-8n mod p. */
+uint64_t crc_uncombine_constant(params_t *params, uint64_t len) {
+    return multpowers(params, params->uncombine_table, len);
+}
+
 /* Find CRC((A * x^(8*len(B))) + B) from CRC(A) and CRC(B) using the value returned by crc_combine_constant. */
 uint64_t crc_combine(params_t *params, uint64_t crc, uint64_t crc2, uint64_t xp) {
     /* It's not clear why we should XOR with the initial. It could be that we
@@ -723,4 +1330,279 @@ uint64_t crc_combine(params_t *params, uint64_t crc, uint64_t crc2, uint64_t xp)
     crc = multmodp(params, crc, xp) ^ crc2;
 
     return crc_final(params, crc);
-}
\ No newline at end of file
+}
+
+
+/* Number of CRCs that crc_combine_many reduces at a time on the stack. */
+#define COMBINE_MANY_BATCH 256
+
+/* Returns x^8len mod p, reusing the last constant if the length didn't change. */
+static uint64_t combine_constant_cached(params_t *params, uint64_t len, uint64_t *last_len, uint64_t *last_xp) {
+    if(len != *last_len) {
+        *last_len = len;
+        *last_xp = crc_combine_constant(params, len);
+    }
+    return *last_xp;
+}
+
+/* Join the CRCs in pairs, then join the pairs, and so on. The products of a
+   level don't depend on each other, so the CPU overlaps their latencies
+   unlike in a chain of crc_combine calls. The CRCs are kept in the form used
+   by the algorithms, where joining A and B is (A + init) * x^8len(B) + B. */
+uint64_t crc_combine_many(params_t *params, uint64_t const *crcs, uint64_t const *lens, uint64_t n) {
+    uint64_t init = crc_initial(params, params->init);
+    uint64_t last_len = 0;
+    uint64_t last_xp = crc_combine_constant(params, 0);
+    uint64_t crc = init;
+
+    uint64_t level[COMBINE_MANY_BATCH];
+    uint64_t level_lens[COMBINE_MANY_BATCH];
+
+    for(uint64_t start = 0; start < n; start += COMBINE_MANY_BATCH) {
+        uint64_t m = n - start < COMBINE_MANY_BATCH ? n - start : COMBINE_MANY_BATCH;
+
+        for(uint64_t i = 0; i < m; i++) {
+            level[i] = crc_initial(params, crcs[start + i]);
+            level_lens[i] = lens[start + i];
+        }
+
+        while(m > 1) {
+            uint64_t half = m / 2;
+
+            for(uint64_t i = 0; i < half; i++) {
+                uint64_t xp = combine_constant_cached(params, level_lens[2*i + 1], &last_len, &last_xp);
+                level[i] = multmodp(params, level[2*i] ^ init, xp) ^ level[2*i + 1];
+                level_lens[i] = level_lens[2*i] + level_lens[2*i + 1];
+            }
+
+            //An odd CRC moves up to the next level unchanged.
+            if(m & 1) {
+                level[half] = level[m - 1];
+                level_lens[half] = level_lens[m - 1];
+            }
+
+            m = half + (m & 1);
+        }
+
+        uint64_t xp = combine_constant_cached(params, level_lens[0], &last_len, &last_xp);
+        crc = multmodp(params, crc ^ init, xp) ^ level[0];
+    }
+
+    return crc_final(params, crc);
+}
+
+/* Find CRC(B) from CRC(AB) and CRC(A). Removing A from the front of the combined
+   message only needs the forward constant:
+   CRC(B) = CRC(AB) - CRC(A) * x^(8*len(B)) mod p */
+uint64_t crc_remove_prefix(params_t *params, uint64_t crc, uint64_t crc_prefix, uint64_t xp) {
+    crc = crc_initial(params, crc);
+    crc_prefix = crc_initial(params, crc_prefix ^ params->init ^ params->xorout);
+
+    crc ^= multmodp(params, crc_prefix, xp);
+
+    return crc_final(params, crc);
+}
+
+/* Find CRC(A) from CRC(AB) and CRC(B) using the value returned by crc_uncombine_constant:
+   CRC(A) = (CRC(AB) - CRC(B)) * x^-(8*len(B)) mod p */
+uint64_t crc_remove_suffix(params_t *params, uint64_t crc, uint64_t crc_suffix, uint64_t xp) {
+    //The xorouts of the two CRCs cancel out, so add back the one removed by crc_initial.
+    crc = crc_initial(params, crc ^ crc_suffix ^ params->xorout);
+    crc = multmodp(params, crc, xp) ^ crc_initial(params, params->init);
+
+    return crc_final(params, crc);
+}
+
+/* The CRC of the whole buffer is built from the block CRCs by Horner's method,
+   as in crc_combine:
+   crc = (crc - init) * x^(8*block_size) + block_crc mod p
+   Only the last block can be shorter, so at most two constants are computed. */
+bool crc_calc_blocks(params_t *params, unsigned char const *buf, uint64_t len, uint64_t block_size, uint64_t *block_crcs, uint64_t *total_crc) {
+    if(block_size == 0) {
+        return false;
+    }
+
+    uint64_t init = crc_initial(params, params->init);
+    uint64_t xp = crc_combine_constant(params, block_size);
+    uint64_t crc = init;
+
+    for(uint64_t i = 0; i * block_size < len; i++) {
+        uint64_t n = len - i * block_size < block_size ? len - i * block_size : block_size;
+        uint64_t block_crc = crc_update(params, init, buf + i * block_size, n);
+
+        if(n < block_size) {
+            xp = crc_combine_constant(params, n);
+        }
+
+        crc = multmodp(params, crc ^ init, xp) ^ block_crc;
+        block_crcs[i] = crc_final(params, block_crc);
+    }
+
+    *total_crc = crc_final(params, crc);
+    return true;
+}
+
+//----------------------------------------
+
+/* Sparse CRC functions */
+
+/* Size of the pages that are checked for zeros by crc_calc_sparse. */
+#define SPARSE_PAGE 4096
+
+/* Runs of zeros shorter than this are applied using the table. */
+#define SPARSE_TABLE_MAX 64
+
+/* Holes shorter than this are folded like data from a block of zeros, which is
+   faster than computing x^8len mod p for them. */
+#define HOLE_FOLD_MAX 512
+
+static const unsigned char zero_block[HOLE_FOLD_MAX] = {0};
+
+/* Apply len zero bytes to crc. Multiplying by x^8len mod p takes O(log len) time. */
+static uint64_t crc_skip_zeros(params_t *params, uint64_t crc, uint64_t len) {
+    if(len < SPARSE_TABLE_MAX) {
+        return crc_zeros(params, crc, 8 * len);
+    }
+    return multmodp(params, crc, crc_combine_constant(params, len));
+}
+
+/* Check if a page is all zeros. The page is read 64 bytes at a time so that the
+   OR of each block can be vectorized, and the check stops at the first block
+   with a non-zero byte. */
+static bool page_is_zero(unsigned char const *page) {
+    for(uint64_t i = 0; i < SPARSE_PAGE; i += 64) {
+        uint64_t w[8];
+        memcpy(w, page + i, 64);
+        if(w[0] | w[1] | w[2] | w[3] | w[4] | w[5] | w[6] | w[7]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/* Compute the CRC of a buffer, skipping any aligned pages that are all zeros. */
+static uint64_t crc_sparse_region(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    unsigned char const *end = buf + len;
+    unsigned char const *data = buf;
+    unsigned char const *page = buf + (SPARSE_PAGE - ((uintptr_t)buf % SPARSE_PAGE)) % SPARSE_PAGE;
+
+    while(page <= end && (uint64_t)(end - page) >= SPARSE_PAGE) {
+        if(!page_is_zero(page)) {
+            page += SPARSE_PAGE;
+            continue;
+        }
+
+        //Extend the run over the following zero pages.
+        unsigned char const *run = page + SPARSE_PAGE;
+        while((uint64_t)(end - run) >= SPARSE_PAGE && page_is_zero(run)) {
+            run += SPARSE_PAGE;
+        }
+
+        crc = crc_update(params, crc, data, page - data);
+        crc = crc_skip_zeros(params, crc, run - page);
+        data = page = run;
+    }
+
+    return crc_update(params, crc, data, end - data);
+}
+
+/* Apply a hole of len zero bytes to crc. */
+static uint64_t crc_hole(params_t *params, uint64_t crc, uint64_t len) {
+    if(len < HOLE_FOLD_MAX) {
+        return crc_update(params, crc, zero_block, len);
+    }
+    return crc_skip_zeros(params, crc, len);
+}
+
+/* Compute the CRC of buf, treating the holes as zeros. The data between the
+   holes is checked for all-zero pages if sparse is true. */
+static uint64_t crc_calc_holes(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *holes, uint64_t n, bool sparse) {
+    uint64_t pos = 0;
+
+    crc = crc_initial(params, crc);
+
+    for(uint64_t i = 0; i < n && pos < len; i++) {
+        uint64_t start = holes[i].offset > pos ? holes[i].offset : pos;
+        uint64_t stop = holes[i].len > len - holes[i].offset ? len : holes[i].offset + holes[i].len;
+
+        if(holes[i].offset >= len) {
+            break;
+        }
+
+        if(stop <= start) {
+            continue;
+        }
+
+        if(sparse) {
+            crc = crc_sparse_region(params, crc, buf + pos, start - pos);
+        } else {
+            crc = crc_update(params, crc, buf + pos, start - pos);
+        }
+
+        crc = crc_hole(params, crc, stop - start);
+        pos = stop;
+    }
+
+    if(sparse) {
+        crc = crc_sparse_region(params, crc, buf + pos, len - pos);
+    } else {
+        crc = crc_update(params, crc, buf + pos, len - pos);
+    }
+
+    return crc_final(params, crc);
+}
+
+uint64_t crc_calc_sparse(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *holes, uint64_t n) {
+    return crc_calc_holes(params, crc, buf, len, holes, n, true);
+}
+
+uint64_t crc_calc_masked(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *zero_ranges, uint64_t n) {
+    return crc_calc_holes(params, crc, buf, len, zero_ranges, n, false);
+}
+
+//----------------------------------------
+
+/* Out-of-order assembly */
+
+/* The CRC of a message is the initial value shifted past the whole message plus
+   the data of each piece shifted past the bytes that follow it:
+   CRC = init * x^(8*len) + sum(data(piece) * x^(8*(len - end))) mod p
+   The terms can be added in any order, so each piece is XORed into the result
+   with an atomic operation. */
+void crc_assembler_init(crc_assembler_t *assembler, params_t *params, uint64_t len) {
+    assembler->params = params;
+    assembler->len = len;
+    assembler->crc = multmodp(params, crc_initial(params, params->init), crc_combine_constant(params, len));
+    assembler->covered = 0;
+}
+
+bool crc_assembler_add(crc_assembler_t *assembler, uint64_t offset, unsigned char const *buf, uint64_t len) {
+    params_t *params = assembler->params;
+    return crc_assembler_add_crc(assembler, offset, crc_calc(params, params->init, buf, len), len);
+}
+
+bool crc_assembler_add_crc(crc_assembler_t *assembler, uint64_t offset, uint64_t crc, uint64_t len) {
+    params_t *params = assembler->params;
+
+    if(offset > assembler->len || len > assembler->len - offset) {
+        return false;
+    }
+
+    //Remove the initial value from the CRC of the piece, leaving only its data.
+    crc = crc_initial(params, crc);
+    crc ^= multmodp(params, crc_initial(params, params->init), crc_combine_constant(params, len));
+    crc = multmodp(params, crc, crc_combine_constant(params, assembler->len - offset - len));
+
+    //The result must be complete before the piece is counted.
+    atomic_xor64(&assembler->crc, crc);
+    atomic_add64(&assembler->covered, len);
+    return true;
+}
+
+bool crc_assembler_done(crc_assembler_t *assembler) {
+    return atomic_load64(&assembler->covered) == assembler->len;
+}
+
+uint64_t crc_assembler_result(crc_assembler_t *assembler) {
+    return crc_final(assembler->params, atomic_load64(&assembler->crc));
+}
@@ -18,12 +18,33 @@ typedef struct {
     bool refout;
     uint64_t init;
     uint64_t xorout;
-    uint64_t k1, k2, k3, k4;
+    uint64_t k1, k2, k3, k4, k5, k6, k7, k8;
     uint64_t u;
     uint64_t table[256];
+    union {
+        uint8_t u8[256];
+        uint16_t u16[256];
+        uint32_t u32[256];
+    } compact_table; //table narrowed to the smallest of 8, 16 or 32 bits that holds the CRC.
     uint64_t combine_table[64];
+    uint64_t uncombine_table[64];
 } params_t;
 
+/* Lengths at which crc_calc switches between algorithms. Any values that
+   respect the minimums produce the same CRCs. The defaults can be replaced with
+   values measured on the current CPU by crc_autotune (tune.h). crc_autotune and
+   crc_tuning_load store each field atomically, so they can run while other
+   threads compute CRCs. Other writes to crc_tuning must happen before the
+   threads that compute CRCs are started. */
+typedef struct {
+    uint64_t clmul_min; //Buffers shorter than this use the table-based algorithm. At least 16.
+    uint64_t align_min; //Buffers of at least this length are aligned before folding.
+    uint64_t fold4_min; //Bytes needed after the first block to fold by 4. At least 48.
+    uint64_t shuffle_min; //Buffers shorter than this use the table-based algorithm if CLMUL isn't available.
+} crc_tuning_t;
+
+extern crc_tuning_t DLL_EXPORT crc_tuning;
+
 /* Create a params_t struct and initialize it with the provided parameters.
    Calculate the values of k1, k2, and the table. */
 params_t DLL_EXPORT crc_params(uint8_t width, uint64_t poly, uint64_t init, bool refin, bool refout, uint64_t xorout, uint64_t check, uint8_t *error);
@@ -50,6 +71,24 @@ uint64_t DLL_EXPORT crc_table(params_t *params, uint64_t crc, unsigned char cons
    initial CRC value.*/
 uint64_t DLL_EXPORT crc_calc(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
 
+/* crc_calc with the lengths in tuning instead of crc_tuning. Used to measure
+   other lengths without changing crc_tuning. */
+uint64_t DLL_EXPORT crc_calc_tuned(params_t *params, crc_tuning_t const *tuning, uint64_t crc, unsigned char const *buf, uint64_t len);
+
+/* Calculate the CRC of a buffer that is preceded by at least 16 readable bytes,
+   such as one allocated with slack around it. Those bytes are read but don't
+   affect the CRC. Skipping the handling of unaligned starts and partial blocks
+   lowers the latency of short and medium buffers. Use params.init as the
+   initial CRC value. */
+uint64_t DLL_EXPORT crc_calc_padded(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+
+/* Calculate the CRC of count elements of elem_len bytes that start stride bytes
+   apart, such as the rows of an image with padding after each row or a field of
+   an array of records. The result is the CRC of the elements concatenated, but
+   they aren't copied. stride can be negative, such as for images stored bottom
+   up. Use params.init as the initial CRC value. */
+uint64_t DLL_EXPORT crc_calc_strided(params_t *params, uint64_t crc, unsigned char const *base, uint64_t elem_len, int64_t stride, uint64_t count);
+
 /* Compute the combine constant to be used in crc_combine. len is the length of
    the second CRC's message. It only needs to be calculated once for each length. */
 uint64_t DLL_EXPORT crc_combine_constant(params_t *params, uint64_t len);
@@ -57,6 +96,79 @@ uint64_t DLL_EXPORT crc_combine_constant(params_t *params, uint64_t len);
 /* Combine two CRCs. xp is the constant returned by crc_combine_constant. */
 uint64_t DLL_EXPORT crc_combine(params_t *params, uint64_t crc, uint64_t crc2, uint64_t xp);
 
+/* Combine the CRCs of n consecutive messages, where lens holds the length of
+   each message. Faster than calling crc_combine n - 1 times, especially when
+   many of the messages have the same length. Returns params.init if n is 0. */
+uint64_t DLL_EXPORT crc_combine_many(params_t *params, uint64_t const *crcs, uint64_t const *lens, uint64_t n);
+
+/* Compute the constant to be used in crc_remove_suffix. len is the length of
+   the suffix. It only needs to be calculated once for each length. */
+uint64_t DLL_EXPORT crc_uncombine_constant(params_t *params, uint64_t len);
+
+/* Remove a prefix from a combined CRC. crc is the CRC of the whole message,
+   crc_prefix is the CRC of the prefix, and xp is the constant returned by
+   crc_combine_constant for the length of the rest of the message. Returns the
+   CRC of the rest of the message. */
+uint64_t DLL_EXPORT crc_remove_prefix(params_t *params, uint64_t crc, uint64_t crc_prefix, uint64_t xp);
+
+/* Remove a suffix from a combined CRC. crc is the CRC of the whole message,
+   crc_suffix is the CRC of the suffix, and xp is the constant returned by
+   crc_uncombine_constant for the length of the suffix. Returns the CRC of the
+   rest of the message. */
+uint64_t DLL_EXPORT crc_remove_suffix(params_t *params, uint64_t crc, uint64_t crc_suffix, uint64_t xp);
+
+/* Calculate the CRC of each block of block_size bytes of buf, and the CRC of the
+   whole buffer from the block CRCs, reading buf once. The last block may be
+   shorter. block_crcs must hold ceil(len / block_size) CRCs. Returns false if
+   block_size is 0. */
+bool DLL_EXPORT crc_calc_blocks(params_t *params, unsigned char const *buf, uint64_t len, uint64_t block_size, uint64_t *block_crcs, uint64_t *total_crc);
+
+/* A range of bytes in a buffer. */
+typedef struct {
+    uint64_t offset;
+    uint64_t len;
+} range_t;
+
+/* Calculate the CRC of a buffer that may contain long runs of zeros. Pages of
+   4 KiB that are all zeros are skipped in O(log n) time instead of being folded.
+   holes lists n ranges of buf that are treated as zeros without being read,
+   such as the holes of a sparse file. They must be sorted by offset and must not
+   overlap. Use params.init as the initial CRC value. */
+uint64_t DLL_EXPORT crc_calc_sparse(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *holes, uint64_t n);
+
+/* Calculate the CRC of buf as if the n zero_ranges were filled with zeros, such
+   as a header with its own CRC field zeroed, without copying the buffer. The
+   ranges aren't read. They must be sorted by offset and must not overlap. Use
+   params.init as the initial CRC value. */
+uint64_t DLL_EXPORT crc_calc_masked(params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, range_t const *zero_ranges, uint64_t n);
+
+/* Accumulates the CRC of a message whose pieces arrive in any order, such as the
+   chunks of a multipart upload. Pieces can be added from several threads at once
+   without locking. The fields are for internal use. */
+typedef struct {
+    params_t *params;
+    uint64_t len;
+    uint64_t crc;
+    uint64_t covered;
+} crc_assembler_t;
+
+/* Prepare an assembler for a message of len bytes. */
+void DLL_EXPORT crc_assembler_init(crc_assembler_t *assembler, params_t *params, uint64_t len);
+
+/* Add the len bytes of the message that start at offset. Pieces must not overlap.
+   Returns false if the piece extends past the end of the message. */
+bool DLL_EXPORT crc_assembler_add(crc_assembler_t *assembler, uint64_t offset, unsigned char const *buf, uint64_t len);
+
+/* Add a piece of the message by its CRC, which must be calculated with
+   params.init as the initial CRC value. */
+bool DLL_EXPORT crc_assembler_add_crc(crc_assembler_t *assembler, uint64_t offset, uint64_t crc, uint64_t len);
+
+/* Check if every byte of the message was added. */
+bool DLL_EXPORT crc_assembler_done(crc_assembler_t *assembler);
+
+/* Return the CRC of the message. Only valid once crc_assembler_done returns true. */
+uint64_t DLL_EXPORT crc_assembler_result(crc_assembler_t *assembler);
+
 /* For internal use: Apply n zeros to crc. */
 uint64_t DLL_EXPORT crc_zeros(params_t *params, uint64_t crc, uint64_t n);
 
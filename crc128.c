@@ -0,0 +1,473 @@
+#include "crc128.h"
+
+#ifndef DISABLE_SIMD
+#include "cpu.h"
+#include "intrinsics.h"
+#endif
+
+/* Buffers shorter than this are computed with the table. The folding loop
+   needs 64 bytes to start. */
+#define CRC128_CLMUL_MIN 64
+
+static crc128_t multmodp128(params128_t *params, crc128_t a, crc128_t b);
+
+//----------------------------------------
+
+/* 128-bit helpers */
+
+static crc128_t xor128(crc128_t a, crc128_t b) {
+    crc128_t c = {a.hi ^ b.hi, a.lo ^ b.lo};
+    return c;
+}
+
+/* Shift to the left by n bits, where n < 128. */
+static crc128_t shl128(crc128_t a, uint8_t n) {
+    crc128_t c;
+    if(n == 0) {
+        return a;
+    } else if(n < 64) {
+        c.hi = (a.hi << n) | (a.lo >> (64 - n));
+        c.lo = a.lo << n;
+    } else {
+        c.hi = a.lo << (n - 64);
+        c.lo = 0;
+    }
+    return c;
+}
+
+/* Shift to the right by n bits, where n < 128. */
+static crc128_t shr128(crc128_t a, uint8_t n) {
+    crc128_t c;
+    if(n == 0) {
+        return a;
+    } else if(n < 64) {
+        c.lo = (a.lo >> n) | (a.hi << (64 - n));
+        c.hi = a.hi >> n;
+    } else {
+        c.lo = a.hi >> (n - 64);
+        c.hi = 0;
+    }
+    return c;
+}
+
+static uint64_t reflect64(uint64_t x) {
+    x = ((x >> 32) & 0xffffffff) | ((x << 32) & 0xffffffff00000000);
+    x = ((x >> 16) & 0xffff0000ffff) | ((x << 16) & 0xffff0000ffff0000);
+    x = ((x >> 8) & 0xff00ff00ff00ff) | ((x << 8) & 0xff00ff00ff00ff00);
+    x = ((x >> 4) & 0xf0f0f0f0f0f0f0f) | ((x << 4) & 0xf0f0f0f0f0f0f0f0);
+    x = ((x >> 2) & 0x3333333333333333) | ((x << 2) & 0xcccccccccccccccc);
+    x = ((x >> 1) & 0x5555555555555555) | ((x << 1) & 0xaaaaaaaaaaaaaaaa);
+    return x;
+}
+
+/* Reflect the low w bits of x. */
+static crc128_t reflect128(crc128_t x, uint8_t w) {
+    crc128_t c = {reflect64(x.lo), reflect64(x.hi)};
+    return shr128(c, 128 - w);
+}
+
+/* Multiply by x mod p. */
+static crc128_t mulx(params128_t *params, crc128_t a) {
+    bool carry = a.hi >> 63;
+    a = shl128(a, 1);
+    return carry ? xor128(a, params->poly) : a;
+}
+
+/* Computes (a * b) mod p without CLMUL, 4 bits of a at a time, like multmodp_sw
+   in crc.c. mult holds the products of b with every polynomial of degree < 4,
+   and red the values of the 4 bits that overflow x^128 at each step, so the
+   product is reduced as it's accumulated. */
+static crc128_t multmodp128_sw(params128_t *params, crc128_t a, crc128_t b) {
+    crc128_t mult[16], red[16];
+    crc128_t prod = {0, 0};
+
+    mult[0] = red[0] = prod;
+    mult[1] = b;
+    red[1] = params->poly; //x^128 mod p
+
+    for(uint8_t i = 1; i < 4; i++) {
+        mult[1 << i] = mulx(params, mult[1 << (i - 1)]);
+        red[1 << i] = mulx(params, red[1 << (i - 1)]);
+    }
+
+    for(uint8_t i = 3; i < 16; i++) {
+        uint8_t low = i & -i;
+        if(i != low) {
+            mult[i] = xor128(mult[i ^ low], mult[low]);
+            red[i] = xor128(red[i ^ low], red[low]);
+        }
+    }
+
+    //Horner's method over the 4-bit digits of a, starting from the highest powers.
+    for(int i = 31; i >= 0; i--) {
+        uint8_t digit = (uint8_t)((i >= 16 ? a.hi >> (4 * i - 64) : a.lo >> (4 * i)) & 0xf);
+        uint8_t overflow = (uint8_t)(prod.hi >> 60);
+        prod = xor128(xor128(shl128(prod, 4), red[overflow]), mult[digit]);
+    }
+
+    return prod;
+}
+
+//----------------------------------------
+
+/* CRC parameters */
+
+/* As in crc_params, the polynomial is scaled to 128 bits, so that p is x^128 + poly.
+   The CRC is scaled the same way, which lets the algorithms ignore the width. */
+
+static crc128_t crc128_initial(params128_t *params, crc128_t crc) {
+    crc = xor128(crc, params->xorout);
+    if(params->refout) {
+        crc = reflect128(crc, params->width);
+    }
+    return shl128(crc, 128 - params->width);
+}
+
+static crc128_t crc128_final(params128_t *params, crc128_t crc) {
+    crc = shr128(crc, 128 - params->width);
+    if(params->refout) {
+        crc = reflect128(crc, params->width);
+    }
+    return xor128(crc, params->xorout);
+}
+
+/* For refin, the table-based algorithm works on the reflection of the CRC, so
+   that the bits of the incoming bytes don't have to be reversed. The table is
+   reflected the same way. Only the entries of the single bits are computed by
+   shifting, and the rest by linearity, as in crc_build_table. */
+static void crc128_build_table(params128_t *params) {
+    params->table[0] = (crc128_t){0, 0};
+
+    for(uint16_t i = 1; i < 256; i <<= 1) {
+        uint8_t byte = params->refin ? (uint8_t)(reflect64(i) >> 56) : (uint8_t)i;
+        crc128_t crc = {(uint64_t)byte << 56, 0};
+
+        for(uint8_t j = 0; j < 8; j++) {
+            crc = mulx(params, crc);
+        }
+
+        params->table[i] = params->refin ? reflect128(crc, 128) : crc;
+    }
+
+    for(uint16_t i = 3; i < 256; i++) {
+        uint16_t low = i & -i;
+        if(i != low) {
+            params->table[i] = xor128(params->table[i ^ low], params->table[low]);
+        }
+    }
+}
+
+/* Fills combine_table with values of x^(8*2^i) mod p. */
+static void crc128_build_combine_table(params128_t *params) {
+    crc128_t sq = {0, (uint64_t)1 << 8};
+    params->combine_table[0] = sq;
+
+    for(uint8_t i = 1; i < 64; i++) {
+        sq = multmodp128(params, sq, sq);
+        params->combine_table[i] = sq;
+    }
+}
+
+/* Computes x^192 / p by long division. The quotient has 65 bits, and the
+   leading x^64 isn't stored. */
+static uint64_t crc128_xndivp(params128_t *params) {
+    crc128_t mod = params->poly; //x^128 mod p
+    uint64_t div = 0;
+
+    for(uint8_t i = 0; i < 64; i++) {
+        div = (div << 1) | (mod.hi >> 63);
+        mod = mulx(params, mod);
+    }
+
+    return div;
+}
+
+params128_t crc128_params(uint8_t width, crc128_t poly, crc128_t init, bool refin, bool refout, crc128_t xorout, crc128_t check, uint8_t *error) {
+    #ifndef DISABLE_SIMD
+    cpu_check_features();
+    #endif
+
+    params128_t params = {0};
+    *error = 0;
+
+    if(width == 0 || width > 128) {
+        *error |= CRC_WIDTH_NOT_SUPPORTED;
+        return params;
+    }
+
+    if(width < 128) {
+        if(shr128(poly, width).hi || shr128(poly, width).lo) {
+            *error |= CRC_POLY_BIG;
+        }
+        if(shr128(init, width).hi || shr128(init, width).lo) {
+            *error |= CRC_INIT_BIG;
+        }
+        if(shr128(xorout, width).hi || shr128(xorout, width).lo) {
+            *error |= CRC_XOROUT_BIG;
+        }
+    }
+
+    if((poly.lo & 1) != 1) {
+        *error |= CRC_POLY_EVEN;
+    }
+
+    params.width = width;
+    params.poly = shl128(poly, 128 - width);
+    params.refin = refin;
+    params.refout = refout;
+    params.init = xor128(refout ? reflect128(init, width) : init, xorout);
+    params.xorout = xorout;
+
+    crc128_build_table(&params);
+
+    /* The CLMUL multiplication reduces with x^128 mod p, x^192 mod p and u, so
+       they're computed before the other constants. */
+    crc128_t x64 = {1, 0};
+    params.k[8] = params.poly;
+    params.k[9] = multmodp128_sw(&params, params.poly, x64);
+    params.u = crc128_xndivp(&params);
+
+    crc128_build_combine_table(&params);
+
+    //k[8 + i] is x^(128 + 64i) mod p, and k[i] continues the same powers from x^512.
+    crc128_t xp = params.k[9];
+    for(uint8_t n = 2; n < 14; n++) {
+        xp = multmodp128(&params, xp, x64);
+        if(n < 8) {
+            params.k[8 + n] = xp;
+        }
+        if(n >= 6) {
+            params.k[n - 6] = xp;
+        }
+    }
+
+    char *data = "123456789";
+    crc128_t crc = crc128_table(&params, params.init, (unsigned char*) data, 9);
+    if(crc.hi != check.hi || crc.lo != check.lo) {
+        *error |= CRC_CHECK_INVALID;
+    }
+
+    return params;
+}
+
+//----------------------------------------
+
+/* CRC calculation functions */
+
+static crc128_t crc128_bytes(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len) {
+    if(params->refin) {
+        crc = reflect128(crc, 128);
+        while(len--) {
+            uint8_t index = (uint8_t)crc.lo ^ *buf++;
+            crc = xor128(shr128(crc, 8), params->table[index]);
+        }
+        crc = reflect128(crc, 128);
+    } else {
+        while(len--) {
+            uint8_t index = (uint8_t)(crc.hi >> 56) ^ *buf++;
+            crc = xor128(shl128(crc, 8), params->table[index]);
+        }
+    }
+    return crc;
+}
+
+crc128_t crc128_table(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len) {
+    crc = crc128_initial(params, crc);
+    crc = crc128_bytes(params, crc, buf, len);
+    return crc128_final(params, crc);
+}
+
+//----------------------------------------
+
+/* Hardware-accelerated CRC */
+
+#ifndef DISABLE_SIMD
+/* Reverses the bits of a nibble. Used to reverse the bits of each byte. */
+static const unsigned char ALIGN_ARRAY REVERSE_LO_TABLE[] = {0x00, 0x80, 0x40, 0xc0, 0x20, 0xa0, 0x60, 0xe0, 0x10, 0x90, 0x50, 0xd0, 0x30, 0xb0, 0x70, 0xf0};
+static const unsigned char ALIGN_ARRAY REVERSE_HI_TABLE[] = {0x0, 0x8, 0x4, 0xc, 0x2, 0xa, 0x6, 0xe, 0x1, 0x9, 0x5, 0xd, 0x3, 0xb, 0x7, 0xf};
+
+/* Load 16 bytes as a polynomial whose highest term is the first bit of the
+   first byte. The bits of each byte are reversed first for refin. */
+TARGET_ATTRIBUTE
+static uint128_t load128(unsigned char const *buf, bool refin) {
+    uint128_t x = intrin_loadu_le(buf);
+
+    if(refin) {
+        uint128_t lo = intrin_lookup(intrin_loadu_le(REVERSE_LO_TABLE), intrin_nibble_lo(x));
+        uint128_t hi = intrin_lookup(intrin_loadu_le(REVERSE_HI_TABLE), intrin_nibble_hi(x));
+        x = intrin_xor(lo, hi);
+    }
+
+    return intrin_swap(x);
+}
+
+/* Multiply the two 64-bit halves of x by the 128-bit constants in k, placed by
+   the caller so that the high half is multiplied by khi and the low half by klo.
+   The 192-bit products are summed as lo + hi * x^64. */
+TARGET_ATTRIBUTE
+static void fold128(uint128_t x, uint128_t klo, uint128_t khi, uint128_t *lo, uint128_t *hi) {
+    *lo = intrin_tri_xor(*lo, intrin_clmul_lo(x, klo), intrin_clmul_hi(x, klo));
+    *hi = intrin_tri_xor(*hi, intrin_clmul_lo(x, khi), intrin_clmul_hi(x, khi));
+}
+
+/* Reduces the 192-bit value lo + hi * x^64 modulo p with a Barrett Reduction.
+   The quotient is (top * (x^64 + u)) / x^64, where top is the highest 64 bits. */
+TARGET_ATTRIBUTE
+static crc128_t modp128(params128_t *params, uint128_t lo, uint128_t hi) {
+    crc128_t crc;
+    lo = intrin_xor(lo, intrin_shl(hi, 8));
+
+    uint64_t top = intrin_get(hi, 1);
+    uint128_t q = intrin_clmul_lo(intrin_set(0, top), intrin_set(0, params->u));
+    q = intrin_set(0, top ^ intrin_get(q, 1));
+
+    lo = intrin_xor(lo, intrin_clmul_lo(q, intrin_set(0, params->poly.lo)));
+    lo = intrin_xor(lo, intrin_shl(intrin_clmul_lo(q, intrin_set(0, params->poly.hi)), 8));
+
+    crc.hi = intrin_get(lo, 1);
+    crc.lo = intrin_get(lo, 0);
+    return crc;
+}
+
+/* Extends the folding method of crc_clmul to polynomials of up to 128 bits.
+   Since the constants are 128 bits long, each 64-bit half of the accumulators
+   takes two multiplications, and the 192-bit products are added to the next
+   block, which is then reduced with a 128-bit Barrett Reduction.
+
+   The accumulators x3 to x0 hold 64 bytes, x3 being the first 16. Multiplying
+   them by x^512 amounts to multiplying the half at x^(64i) by x^(512+64i) mod p. */
+TARGET_ATTRIBUTE
+static crc128_t crc128_clmul(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len) {
+    bool refin = params->refin;
+    uint128_t fold_lo[4], fold_hi[4], reduce_lo[4], reduce_hi[4];
+
+    for(uint8_t i = 0; i < 4; i++) {
+        crc128_t *k = params->k;
+        fold_lo[i] = intrin_set(k[2*i + 1].lo, k[2*i].lo);
+        fold_hi[i] = intrin_set(k[2*i + 1].hi, k[2*i].hi);
+        reduce_lo[i] = intrin_set(k[8 + 2*i + 1].lo, k[8 + 2*i].lo);
+        reduce_hi[i] = intrin_set(k[8 + 2*i + 1].hi, k[8 + 2*i].hi);
+    }
+
+    uint128_t x3 = intrin_xor(load128(buf, refin), intrin_set(crc.hi, crc.lo));
+    uint128_t x2 = load128(buf + 16, refin);
+    uint128_t x1 = load128(buf + 32, refin);
+    uint128_t x0 = load128(buf + 48, refin);
+    uint128_t lo, hi;
+
+    buf += 64;
+    len -= 64;
+
+    //Fold by 4.
+    while(len >= 64) {
+        lo = hi = intrin_set(0, 0);
+        fold128(x0, fold_lo[0], fold_hi[0], &lo, &hi);
+        fold128(x1, fold_lo[1], fold_hi[1], &lo, &hi);
+        fold128(x2, fold_lo[2], fold_hi[2], &lo, &hi);
+        fold128(x3, fold_lo[3], fold_hi[3], &lo, &hi);
+
+        x3 = load128(buf, refin);
+        x2 = load128(buf + 16, refin);
+        x1 = intrin_xor(load128(buf + 32, refin), intrin_shr(hi, 8));
+        x0 = intrin_tri_xor(load128(buf + 48, refin), lo, intrin_shl(hi, 8));
+
+        buf += 64;
+        len -= 64;
+    }
+
+    //Fold the remaining blocks. x3 moves to x^512 and the rest move up by one.
+    while(len >= 16) {
+        lo = hi = intrin_set(0, 0);
+        fold128(x3, fold_lo[0], fold_hi[0], &lo, &hi);
+
+        x3 = x2;
+        x2 = x1;
+        x1 = intrin_xor(x0, intrin_shr(hi, 8));
+        x0 = intrin_tri_xor(load128(buf, refin), lo, intrin_shl(hi, 8));
+
+        buf += 16;
+        len -= 16;
+    }
+
+    //Multiply by x^128 and reduce to 192 bits.
+    lo = hi = intrin_set(0, 0);
+    fold128(x0, reduce_lo[0], reduce_hi[0], &lo, &hi);
+    fold128(x1, reduce_lo[1], reduce_hi[1], &lo, &hi);
+    fold128(x2, reduce_lo[2], reduce_hi[2], &lo, &hi);
+    fold128(x3, reduce_lo[3], reduce_hi[3], &lo, &hi);
+
+    return crc128_bytes(params, modp128(params, lo, hi), buf, len);
+}
+
+/* Computes (a * b) mod p with the CLMUL instruction. The 256-bit product takes
+   four multiplications, and its high half is folded into 192 bits with
+   x^128 mod p and x^192 mod p, like the last step of crc128_clmul. */
+TARGET_ATTRIBUTE
+static crc128_t multmodp128_hw(params128_t *params, crc128_t a, crc128_t b) {
+    uint128_t x = intrin_set(a.hi, a.lo);
+    uint128_t y = intrin_set(b.hi, b.lo);
+    uint128_t mid = intrin_xor(intrin_clmul_lo(x, intrin_set(0, b.hi)), intrin_clmul_hi(x, intrin_set(b.lo, 0)));
+    uint128_t lo = intrin_xor(intrin_clmul_lo(x, y), intrin_shl(mid, 8));
+    uint128_t top = intrin_xor(intrin_clmul_hi(x, y), intrin_shr(mid, 8));
+
+    uint128_t klo = intrin_set(params->k[9].lo, params->k[8].lo);
+    uint128_t khi = intrin_set(params->k[9].hi, params->k[8].hi);
+    uint128_t hi = intrin_set(0, 0);
+    fold128(top, klo, khi, &lo, &hi);
+
+    return modp128(params, lo, hi);
+}
+#endif
+
+static crc128_t multmodp128(params128_t *params, crc128_t a, crc128_t b) {
+    #ifndef DISABLE_SIMD
+    if(cpu_enable_simd) {
+        return multmodp128_hw(params, a, b);
+    }
+    #endif
+
+    return multmodp128_sw(params, a, b);
+}
+
+crc128_t crc128_calc(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len) {
+    crc = crc128_initial(params, crc);
+
+    #ifndef DISABLE_SIMD
+    if(cpu_enable_simd && len >= CRC128_CLMUL_MIN) {
+        crc = crc128_clmul(params, crc, buf, len);
+    } else {
+        crc = crc128_bytes(params, crc, buf, len);
+    }
+
+    #else
+    crc = crc128_bytes(params, crc, buf, len);
+    #endif
+
+    return crc128_final(params, crc);
+}
+
+//----------------------------------------
+
+/* CRC combine functions */
+
+crc128_t crc128_combine_constant(params128_t *params, uint64_t len) {
+    crc128_t xp = {0, 1};
+
+    for(uint8_t i = 0; len; i++, len >>= 1) {
+        if(len & 1) {
+            xp = multmodp128(params, xp, params->combine_table[i]);
+        }
+    }
+
+    return xp;
+}
+
+crc128_t crc128_combine(params128_t *params, crc128_t crc, crc128_t crc2, crc128_t xp) {
+    crc = xor128(crc, xor128(params->init, params->xorout));
+    crc = crc128_initial(params, crc);
+    crc2 = crc128_initial(params, crc2);
+
+    crc = xor128(multmodp128(params, crc, xp), crc2);
+
+    return crc128_final(params, crc);
+}
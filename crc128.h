@@ -0,0 +1,52 @@
+#ifndef CRC_CLMUL_128_H
+#define CRC_CLMUL_128_H
+
+#include "crc.h"
+
+/* A value of a CRC with a width of up to 128 bits. */
+typedef struct {
+    uint64_t hi;
+    uint64_t lo;
+} crc128_t;
+
+/* Holds the CRC parameters and constants of CRCs with a width of up to 128
+   bits. The values are always kept in the non-reflected domain, and the bits of
+   each incoming byte are reversed if refin is true.
+
+   k holds x^(512+64i) mod p for folding by 64 bytes, followed by x^(128+64i) mod p
+   for reducing the folded buffer. u is x^192 / p without the leading term, used
+   for the Barrett Reduction. */
+typedef struct {
+    uint8_t width;
+    crc128_t poly;
+    bool refin;
+    bool refout;
+    crc128_t init;
+    crc128_t xorout;
+    crc128_t k[16];
+    uint64_t u;
+    crc128_t table[256];
+    crc128_t combine_table[64];
+} params128_t;
+
+/* Create a params128_t struct and initialize it with the provided parameters.
+   Any width from 1 to 128 is supported. Errors are reported like in crc_params. */
+params128_t DLL_EXPORT crc128_params(uint8_t width, crc128_t poly, crc128_t init, bool refin, bool refout, crc128_t xorout, crc128_t check, uint8_t *error);
+
+/* Calculate the CRC using the table-based algorithm.
+   Use params.init as the initial CRC value. */
+crc128_t DLL_EXPORT crc128_table(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len);
+
+/* Calculate the CRC using the SIMD algorithm. Falls back to the table-based
+   algorithm if SIMD intrinsics are not available. Use params.init as the
+   initial CRC value. */
+crc128_t DLL_EXPORT crc128_calc(params128_t *params, crc128_t crc, unsigned char const *buf, uint64_t len);
+
+/* Compute the combine constant to be used in crc128_combine. len is the length
+   of the second CRC's message. */
+crc128_t DLL_EXPORT crc128_combine_constant(params128_t *params, uint64_t len);
+
+/* Combine two CRCs. xp is the constant returned by crc128_combine_constant. */
+crc128_t DLL_EXPORT crc128_combine(params128_t *params, crc128_t crc, crc128_t crc2, crc128_t xp);
+
+#endif
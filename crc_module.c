@@ -0,0 +1,214 @@
+/* CPython extension module for the library. Build with setup.py. */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+#include <structmember.h>
+#include <stddef.h>
+#include "crc.h"
+
+/* Buffers shorter than this are computed without releasing the GIL, since
+   releasing and reacquiring it costs more than the CRC itself. */
+#define GIL_MINSIZE 2048
+
+//----------------------------------------
+
+/* Params type */
+
+/* Wraps a params_t struct so that it's passed to the library by reference. */
+typedef struct {
+    PyObject_HEAD
+    params_t params;
+} ParamsObject;
+
+/* Build the exception message from the errors emitted by crc_params. */
+static PyObject *params_error(uint8_t error) {
+    static const char *messages[] = {
+        "width should be larger than 0 and less than or equal to 64",
+        "poly width is larger than the width parameter",
+        "init width is larger than the width parameter",
+        "xorout width is larger than the width parameter",
+        "CRC polynomial is even",
+        "check value doesn't match the CRC computed from the provided parameters"
+    };
+
+    PyObject *list = PyList_New(0);
+    if(list == NULL) {
+        return NULL;
+    }
+
+    for(uint8_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+        if(error & (1 << i)) {
+            PyObject *message = PyUnicode_FromString(messages[i]);
+            if(message == NULL || PyList_Append(list, message) < 0) {
+                Py_XDECREF(message);
+                Py_DECREF(list);
+                return NULL;
+            }
+            Py_DECREF(message);
+        }
+    }
+
+    PyObject *separator = PyUnicode_FromString(", ");
+    PyObject *text = separator ? PyUnicode_Join(separator, list) : NULL;
+
+    if(text != NULL) {
+        PyErr_Format(PyExc_ValueError, "Invalid CRC parameters: %U.", text);
+    }
+
+    Py_XDECREF(text);
+    Py_XDECREF(separator);
+    Py_DECREF(list);
+    return NULL;
+}
+
+static PyObject *Params_new(PyTypeObject *type, PyObject *args, PyObject *kwds) {
+    static char *keywords[] = {"width", "poly", "init", "refin", "refout", "xorout", "check", NULL};
+    unsigned char width;
+    unsigned long long poly, init, xorout, check;
+    int refin, refout;
+
+    if(!PyArg_ParseTupleAndKeywords(args, kwds, "bKKppKK", keywords, &width, &poly, &init, &refin, &refout, &xorout, &check)) {
+        return NULL;
+    }
+
+    ParamsObject *self = (ParamsObject*) type->tp_alloc(type, 0);
+    if(self == NULL) {
+        return NULL;
+    }
+
+    uint8_t error;
+    self->params = crc_params(width, poly, init, refin, refout, xorout, check, &error);
+
+    if(error) {
+        Py_DECREF(self);
+        return params_error(error);
+    }
+
+    return (PyObject*) self;
+}
+
+static PyMemberDef Params_members[] = {
+    {"width", T_UBYTE, offsetof(ParamsObject, params.width), READONLY, "Width of the polynomial."},
+    {"poly", T_ULONGLONG, offsetof(ParamsObject, params.poly), READONLY, "Polynomial, reflected or scaled to 64 bits."},
+    {"refin", T_BOOL, offsetof(ParamsObject, params.refin), READONLY, "Reflect the incoming bytes."},
+    {"refout", T_BOOL, offsetof(ParamsObject, params.refout), READONLY, "Reflect the result."},
+    {"init", T_ULONGLONG, offsetof(ParamsObject, params.init), READONLY, "CRC of an empty buffer. Used as the initial CRC value."},
+    {"xorout", T_ULONGLONG, offsetof(ParamsObject, params.xorout), READONLY, "Value XORed with the result."},
+    {NULL}
+};
+
+static PyTypeObject ParamsType = {
+    PyVarObject_HEAD_INIT(NULL, 0)
+    .tp_name = "crc_clmul.Params",
+    .tp_doc = PyDoc_STR("Params(width, poly, init, refin, refout, xorout, check)\n\nCRC parameters and precomputed constants."),
+    .tp_basicsize = sizeof(ParamsObject),
+    .tp_itemsize = 0,
+    .tp_flags = Py_TPFLAGS_DEFAULT,
+    .tp_new = Params_new,
+    .tp_members = Params_members
+};
+
+//----------------------------------------
+
+/* Module functions */
+
+/* Computes the CRC of any object supporting the buffer protocol using f. The
+   buffer is used in place and the GIL is released for large buffers. */
+static PyObject *buffer_crc(PyObject *args, uint64_t (*f)(params_t*, uint64_t, unsigned char const*, uint64_t)) {
+    ParamsObject *self;
+    unsigned long long crc;
+    Py_buffer view;
+
+    if(!PyArg_ParseTuple(args, "O!Ky*", &ParamsType, &self, &crc, &view)) {
+        return NULL;
+    }
+
+    if(view.len >= GIL_MINSIZE) {
+        Py_BEGIN_ALLOW_THREADS
+        crc = f(&self->params, crc, (unsigned char const*) view.buf, view.len);
+        Py_END_ALLOW_THREADS
+    } else {
+        crc = f(&self->params, crc, (unsigned char const*) view.buf, view.len);
+    }
+
+    PyBuffer_Release(&view);
+    return PyLong_FromUnsignedLongLong(crc);
+}
+
+static PyObject *module_crc_table(PyObject *module, PyObject *args) {
+    return buffer_crc(args, crc_table);
+}
+
+static PyObject *module_crc_calc(PyObject *module, PyObject *args) {
+    return buffer_crc(args, crc_calc);
+}
+
+static PyObject *module_crc_zeros(PyObject *module, PyObject *args) {
+    ParamsObject *self;
+    unsigned long long crc, n;
+
+    if(!PyArg_ParseTuple(args, "O!KK", &ParamsType, &self, &crc, &n)) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLongLong(crc_zeros(&self->params, crc, n));
+}
+
+static PyObject *module_crc_combine_constant(PyObject *module, PyObject *args) {
+    ParamsObject *self;
+    unsigned long long len;
+
+    if(!PyArg_ParseTuple(args, "O!K", &ParamsType, &self, &len)) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLongLong(crc_combine_constant(&self->params, len));
+}
+
+static PyObject *module_crc_combine(PyObject *module, PyObject *args) {
+    ParamsObject *self;
+    unsigned long long crc, crc2, xp;
+
+    if(!PyArg_ParseTuple(args, "O!KKK", &ParamsType, &self, &crc, &crc2, &xp)) {
+        return NULL;
+    }
+
+    return PyLong_FromUnsignedLongLong(crc_combine(&self->params, crc, crc2, xp));
+}
+
+static PyMethodDef module_methods[] = {
+    {"crc_table", module_crc_table, METH_VARARGS, PyDoc_STR("crc_table(params, crc, buf)\n\nCalculate the CRC using the table-based algorithm.")},
+    {"crc_calc", module_crc_calc, METH_VARARGS, PyDoc_STR("crc_calc(params, crc, buf)\n\nCalculate the CRC using the SIMD algorithm.")},
+    {"crc_zeros", module_crc_zeros, METH_VARARGS, PyDoc_STR("crc_zeros(params, crc, n)\n\nApply n zero bits to crc.")},
+    {"crc_combine_constant", module_crc_combine_constant, METH_VARARGS, PyDoc_STR("crc_combine_constant(params, len)\n\nCompute the constant used by crc_combine.")},
+    {"crc_combine", module_crc_combine, METH_VARARGS, PyDoc_STR("crc_combine(params, crc, crc2, xp)\n\nCombine two CRCs.")},
+    {NULL}
+};
+
+static struct PyModuleDef module_def = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "crc_clmul",
+    .m_doc = PyDoc_STR("Hardware-accelerated CRC for all CRC parameters."),
+    .m_size = -1,
+    .m_methods = module_methods
+};
+
+PyMODINIT_FUNC PyInit_crc_clmul(void) {
+    if(PyType_Ready(&ParamsType) < 0) {
+        return NULL;
+    }
+
+    PyObject *module = PyModule_Create(&module_def);
+    if(module == NULL) {
+        return NULL;
+    }
+
+    Py_INCREF(&ParamsType);
+    if(PyModule_AddObject(module, "Params", (PyObject*) &ParamsType) < 0) {
+        Py_DECREF(&ParamsType);
+        Py_DECREF(module);
+        return NULL;
+    }
+
+    return module;
+}
@@ -0,0 +1,452 @@
+#include <stdlib.h>
+#include "identify.h"
+
+/* Length of the pieces of the samples that are passed to every configuration
+   before moving on, small enough to stay in the L1 cache. */
+#define IDENTIFY_CHUNK 8192
+
+//----------------------------------------
+
+/* Catalogue */
+
+/* Taken from Greg Cook's CRC catalogue: https://reveng.sourceforge.io/crc-catalogue/all.htm
+   Note: Keep in sync with test/models.py */
+const crc_model_t crc_catalogue[] = {
+    {"CRC3-GSM", 3, 0x3, 0x0, false, false, 0x7, 0x4},
+    {"CRC3-ROHC", 3, 0x3, 0x7, true, true, 0x0, 0x6},
+    {"CRC4-G-704", 4, 0x3, 0x0, true, true, 0x0, 0x7},
+    {"CRC4-INTERLAKEN", 4, 0x3, 0xf, false, false, 0xf, 0xb},
+    {"CRC5-EPC-C1G2", 5, 0x09, 0x09, false, false, 0x00, 0x00},
+    {"CRC5-G-704", 5, 0x15, 0x00, true, true, 0x00, 0x07},
+    {"CRC5-USB", 5, 0x05, 0x1f, true, true, 0x1f, 0x19},
+    {"CRC6-CDMA2000-A", 6, 0x27, 0x3f, false, false, 0x00, 0x0d},
+    {"CRC6-CDMA2000-B", 6, 0x07, 0x3f, false, false, 0x00, 0x3b},
+    {"CRC6-DARC", 6, 0x19, 0x00, true, true, 0x00, 0x26},
+    {"CRC6-G-704", 6, 0x03, 0x00, true, true, 0x00, 0x06},
+    {"CRC6-GSM", 6, 0x2f, 0x00, false, false, 0x3f, 0x13},
+    {"CRC7-MMC", 7, 0x09, 0x00, false, false, 0x00, 0x75},
+    {"CRC7-ROHC", 7, 0x4f, 0x7f, true, true, 0x00, 0x53},
+    {"CRC7-UMTS", 7, 0x45, 0x00, false, false, 0x00, 0x61},
+    {"CRC8-AUTOSAR", 8, 0x2f, 0xff, false, false, 0xff, 0xdf},
+    {"CRC8-BLUETOOTH", 8, 0xa7, 0x00, true, true, 0x00, 0x26},
+    {"CRC8-CDMA2000", 8, 0x9b, 0xff, false, false, 0x00, 0xda},
+    {"CRC8-DARC", 8, 0x39, 0x00, true, true, 0x00, 0x15},
+    {"CRC8-DVB-S2", 8, 0xd5, 0x00, false, false, 0x00, 0xbc},
+    {"CRC8-GSM-A", 8, 0x1d, 0x00, false, false, 0x00, 0x37},
+    {"CRC8-GSM-B", 8, 0x49, 0x00, false, false, 0xff, 0x94},
+    {"CRC8-HITAG", 8, 0x1d, 0xff, false, false, 0x00, 0xb4},
+    {"CRC8-I-432-1", 8, 0x07, 0x00, false, false, 0x55, 0xa1},
+    {"CRC8-I-CODE", 8, 0x1d, 0xfd, false, false, 0x00, 0x7e},
+    {"CRC8-LTE", 8, 0x9b, 0x00, false, false, 0x00, 0xea},
+    {"CRC8-MAXIM-DOW", 8, 0x31, 0x00, true, true, 0x00, 0xa1},
+    {"CRC8-MIFARE-MAD", 8, 0x1d, 0xc7, false, false, 0x00, 0x99},
+    {"CRC8-NRSC-5", 8, 0x31, 0xff, false, false, 0x00, 0xf7},
+    {"CRC8-OPENSAFETY", 8, 0x2f, 0x00, false, false, 0x00, 0x3e},
+    {"CRC8-ROHC", 8, 0x07, 0xff, true, true, 0x00, 0xd0},
+    {"CRC8-SAE-J1850", 8, 0x1d, 0xff, false, false, 0xff, 0x4b},
+    {"CRC8-SMBUS", 8, 0x07, 0x00, false, false, 0x00, 0xf4},
+    {"CRC8-TECH-3250", 8, 0x1d, 0xff, true, true, 0x00, 0x97},
+    {"CRC8-WCDMA", 8, 0x9b, 0x00, true, true, 0x00, 0x25},
+    {"CRC10-ATM", 10, 0x233, 0x000, false, false, 0x000, 0x199},
+    {"CRC10-CDMA2000", 10, 0x3d9, 0x3ff, false, false, 0x000, 0x233},
+    {"CRC10-GSM", 10, 0x175, 0x000, false, false, 0x3ff, 0x12a},
+    {"CRC11-FLEXRAY", 11, 0x385, 0x01a, false, false, 0x000, 0x5a3},
+    {"CRC11-UMTS", 11, 0x307, 0x000, false, false, 0x000, 0x061},
+    {"CRC12-CDMA2000", 12, 0xf13, 0xfff, false, false, 0x000, 0xd4d},
+    {"CRC12-DECT", 12, 0x80f, 0x000, false, false, 0x000, 0xf5b},
+    {"CRC12-GSM", 12, 0xd31, 0x000, false, false, 0xfff, 0xb34},
+    {"CRC12-UMTS", 12, 0x80f, 0x000, false, true, 0x000, 0xdaf},
+    {"CRC13-BBC", 13, 0x1cf5, 0x0000, false, false, 0x0000, 0x04fa},
+    {"CRC14-DARC", 14, 0x0805, 0x0000, true, true, 0x0000, 0x082d},
+    {"CRC14-GSM", 14, 0x202d, 0x0000, false, false, 0x3fff, 0x30ae},
+    {"CRC15-CAN", 15, 0x4599, 0x0000, false, false, 0x0000, 0x059e},
+    {"CRC15-MPT1327", 15, 0x6815, 0x0000, false, false, 0x0001, 0x2566},
+    {"CRC16-ARC", 16, 0x8005, 0x0000, true, true, 0x0000, 0xbb3d},
+    {"CRC16-CDMA2000", 16, 0xc867, 0xffff, false, false, 0x0000, 0x4c06},
+    {"CRC16-CMS", 16, 0x8005, 0xffff, false, false, 0x0000, 0xaee7},
+    {"CRC16-DDS-110", 16, 0x8005, 0x800d, false, false, 0x0000, 0x9ecf},
+    {"CRC16-DECT-R", 16, 0x0589, 0x0000, false, false, 0x0001, 0x007e},
+    {"CRC16-DECT-X", 16, 0x0589, 0x0000, false, false, 0x0000, 0x007f},
+    {"CRC16-DNP", 16, 0x3d65, 0x0000, true, true, 0xffff, 0xea82},
+    {"CRC16-EN-13757", 16, 0x3d65, 0x0000, false, false, 0xffff, 0xc2b7},
+    {"CRC16-GENIBUS", 16, 0x1021, 0xffff, false, false, 0xffff, 0xd64e},
+    {"CRC16-GSM", 16, 0x1021, 0x0000, false, false, 0xffff, 0xce3c},
+    {"CRC16-IBM-3740", 16, 0x1021, 0xffff, false, false, 0x0000, 0x29b1},
+    {"CRC16-IBM-SDLC", 16, 0x1021, 0xffff, true, true, 0xffff, 0x906e},
+    {"CRC16-ISO-IEC-14443-3-A", 16, 0x1021, 0xc6c6, true, true, 0x0000, 0xbf05},
+    {"CRC16-KERMIT", 16, 0x1021, 0x0000, true, true, 0x0000, 0x2189},
+    {"CRC16-LJ1200", 16, 0x6f63, 0x0000, false, false, 0x0000, 0xbdf4},
+    {"CRC16-M17", 16, 0x5935, 0xffff, false, false, 0x0000, 0x772b},
+    {"CRC16-MAXIM-DOW", 16, 0x8005, 0x0000, true, true, 0xffff, 0x44c2},
+    {"CRC16-MCRF4XX", 16, 0x1021, 0xffff, true, true, 0x0000, 0x6f91},
+    {"CRC16-MODBUS", 16, 0x8005, 0xffff, true, true, 0x0000, 0x4b37},
+    {"CRC16-NRSC-5", 16, 0x080b, 0xffff, true, true, 0x0000, 0xa066},
+    {"CRC16-OPENSAFETY-A", 16, 0x5935, 0x0000, false, false, 0x0000, 0x5d38},
+    {"CRC16-OPENSAFETY-B", 16, 0x755b, 0x0000, false, false, 0x0000, 0x20fe},
+    {"CRC16-PROFIBUS", 16, 0x1dcf, 0xffff, false, false, 0xffff, 0xa819},
+    {"CRC16-RIELLO", 16, 0x1021, 0xb2aa, true, true, 0x0000, 0x63d0},
+    {"CRC16-SPI-FUJITSU", 16, 0x1021, 0x1d0f, false, false, 0x0000, 0xe5cc},
+    {"CRC16-T10-DIF", 16, 0x8bb7, 0x0000, false, false, 0x0000, 0xd0db},
+    {"CRC16-TELEDISK", 16, 0xa097, 0x0000, false, false, 0x0000, 0x0fb3},
+    {"CRC16-TMS37157", 16, 0x1021, 0x89ec, true, true, 0x0000, 0x26b1},
+    {"CRC16-UMTS", 16, 0x8005, 0x0000, false, false, 0x0000, 0xfee8},
+    {"CRC16-USB", 16, 0x8005, 0xffff, true, true, 0xffff, 0xb4c8},
+    {"CRC16-XMODEM", 16, 0x1021, 0x0000, false, false, 0x0000, 0x31c3},
+    {"CRC17-CAN-FD", 17, 0x1685b, 0x00000, false, false, 0x00000, 0x04f03},
+    {"CRC21-CAN-FD", 21, 0x102899, 0x000000, false, false, 0x000000, 0x0ed841},
+    {"CRC24-BLE", 24, 0x00065b, 0x555555, true, true, 0x000000, 0xc25a56},
+    {"CRC24-FLEXRAY-A", 24, 0x5d6dcb, 0xfedcba, false, false, 0x000000, 0x7979bd},
+    {"CRC24-FLEXRAY-B", 24, 0x5d6dcb, 0xabcdef, false, false, 0x000000, 0x1f23b8},
+    {"CRC24-INTERLAKEN", 24, 0x328b63, 0xffffff, false, false, 0xffffff, 0xb4f3e6},
+    {"CRC24-LTE-A", 24, 0x864cfb, 0x000000, false, false, 0x000000, 0xcde703},
+    {"CRC24-LTE-B", 24, 0x800063, 0x000000, false, false, 0x000000, 0x23ef52},
+    {"CRC24-OPENPGP", 24, 0x864cfb, 0xb704ce, false, false, 0x000000, 0x21cf02},
+    {"CRC24-OS-9", 24, 0x800063, 0xffffff, false, false, 0xffffff, 0x200fa5},
+    {"CRC30-CDMA", 30, 0x2030b9c7, 0x3fffffff, false, false, 0x3fffffff, 0x04c34abf},
+    {"CRC31-PHILIPS", 31, 0x04c11db7, 0x7fffffff, false, false, 0x7fffffff, 0x0ce9e46c},
+    {"CRC32-AIXM", 32, 0x814141ab, 0x00000000, false, false, 0x00000000, 0x3010bf7f},
+    {"CRC32-AUTOSAR", 32, 0xf4acfb13, 0xffffffff, true, true, 0xffffffff, 0x1697d06a},
+    {"CRC32-BASE91-D", 32, 0xa833982b, 0xffffffff, true, true, 0xffffffff, 0x87315576},
+    {"CRC32-BZIP2", 32, 0x04c11db7, 0xffffffff, false, false, 0xffffffff, 0xfc891918},
+    {"CRC32-CD-ROM-EDC", 32, 0x8001801b, 0x00000000, true, true, 0x00000000, 0x6ec2edc4},
+    {"CRC32-CKSUM", 32, 0x04c11db7, 0x00000000, false, false, 0xffffffff, 0x765e7680},
+    {"CRC32-ISCSI", 32, 0x1edc6f41, 0xffffffff, true, true, 0xffffffff, 0xe3069283},
+    {"CRC32-ISO-HDLC", 32, 0x04c11db7, 0xffffffff, true, true, 0xffffffff, 0xcbf43926},
+    {"CRC32-JAMCRC", 32, 0x04c11db7, 0xffffffff, true, true, 0x00000000, 0x340bc6d9},
+    {"CRC32-MEF", 32, 0x741b8cd7, 0xffffffff, true, true, 0x00000000, 0xd2c22f51},
+    {"CRC32-MPEG-2", 32, 0x04c11db7, 0xffffffff, false, false, 0x00000000, 0x0376e6e7},
+    {"CRC32-XFER", 32, 0x000000af, 0x00000000, false, false, 0x00000000, 0xbd0be338},
+    {"CRC40-GSM", 40, 0x0004820009, 0x0000000000, false, false, 0xffffffffff, 0xd4164fc646},
+    {"CRC64-ECMA-182", 64, 0x42f0e1eba9ea3693, 0x0000000000000000, false, false, 0x0000000000000000, 0x6c40df5f0b497347},
+    {"CRC64-GO-ISO", 64, 0x000000000000001b, 0xffffffffffffffff, true, true, 0xffffffffffffffff, 0xb90956c775a41001},
+    {"CRC64-MS", 64, 0x259c84cba6426349, 0xffffffffffffffff, true, true, 0x0000000000000000, 0x75d4b74f024eceea},
+    {"CRC64-NVME", 64, 0xad93d23594c93659, 0xffffffffffffffff, true, true, 0xffffffffffffffff, 0xae8b14860a799888},
+    {"CRC64-REDIS", 64, 0xad93d23594c935a9, 0x0000000000000000, true, true, 0x0000000000000000, 0xe9c6d914c4b8d9ca},
+    {"CRC64-WE", 64, 0x42f0e1eba9ea3693, 0xffffffffffffffff, false, false, 0xffffffffffffffff, 0x62ec59e3f1a4f00a},
+    {"CRC64-XZ", 64, 0x42f0e1eba9ea3693, 0xffffffffffffffff, true, true, 0xffffffffffffffff, 0x995dc9bbdf1939fa},
+};
+
+const uint64_t crc_catalogue_size = sizeof(crc_catalogue) / sizeof(crc_model_t);
+
+//----------------------------------------
+
+/* Linear equations over GF(2) */
+
+/* An equation over the bits of init (lo) and xorout (hi). Bit i of init is
+   unknown i and bit i of xorout is unknown 64 + i. */
+typedef struct {
+    uint64_t lo;
+    uint64_t hi;
+    bool rhs;
+} equation_t;
+
+/* The equations in echelon form. The row with pivot i has no unknowns below i. */
+typedef struct {
+    equation_t rows[128];
+    bool used[128];
+    uint8_t rank;
+    bool consistent;
+} system_t;
+
+static bool parity(uint64_t x) {
+    x ^= x >> 32;
+    x ^= x >> 16;
+    x ^= x >> 8;
+    x ^= x >> 4;
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+static uint8_t lowest_unknown(equation_t const *e) {
+    uint64_t x = e->lo ? e->lo : e->hi;
+    uint8_t i = e->lo ? 0 : 64;
+
+    while((x & 1) == 0) {
+        x >>= 1;
+        i++;
+    }
+
+    return i;
+}
+
+/* Eliminate the known pivots from an equation and add it to the system. An
+   equation that reduces to 0 = 1 makes the system inconsistent. */
+static void system_add(system_t *system, equation_t e) {
+    while(e.lo | e.hi) {
+        uint8_t i = lowest_unknown(&e);
+
+        if(!system->used[i]) {
+            system->rows[i] = e;
+            system->used[i] = true;
+            system->rank++;
+            return;
+        }
+
+        e.lo ^= system->rows[i].lo;
+        e.hi ^= system->rows[i].hi;
+        e.rhs ^= system->rows[i].rhs;
+    }
+
+    if(e.rhs) {
+        system->consistent = false;
+    }
+}
+
+static bool system_satisfied(system_t const *system, uint64_t init, uint64_t xorout) {
+    for(uint8_t i = 0; i < 128; i++) {
+        equation_t const *e = &system->rows[i];
+
+        if(system->used[i] && (parity((e->lo & init) ^ (e->hi & xorout)) != e->rhs)) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/* Solve the system by back substitution. The unknowns that aren't determined
+   keep the values they had in init and xorout. */
+static void system_solve(system_t const *system, uint64_t *init, uint64_t *xorout) {
+    for(int i = 127; i >= 0; i--) {
+        equation_t const *e = &system->rows[i];
+
+        if(!system->used[i]) {
+            continue;
+        }
+
+        uint64_t *x = i < 64 ? init : xorout;
+        uint64_t bit = (uint64_t)1 << (i % 64);
+
+        *x &= ~bit;
+        *x |= parity((e->lo & *init) ^ (e->hi & *xorout)) != e->rhs ? bit : 0;
+    }
+}
+
+//----------------------------------------
+
+/* Identification */
+
+static uint64_t reflect_bits(uint64_t x, uint8_t w) {
+    uint64_t y = 0;
+
+    for(uint8_t i = 0; i < w; i++) {
+        y = (y << 1) | (x & 1);
+        x >>= 1;
+    }
+
+    return y;
+}
+
+/* Build the equations of a model with unknown init and xorout. For a message of
+   len bytes, the CRC with init and xorout is the CRC with both set to 0, plus
+   init advanced past len zero bytes, plus xorout. The first term is crc0 and the
+   second is linear in init, so each bit of the CRC gives an equation. params
+   must have init and xorout set to 0. */
+static void identify_system(system_t *system, params_t *params, crc_sample_t const *samples, uint64_t const *crc0, uint64_t n) {
+    uint8_t w = params->width;
+    uint64_t columns[64];
+    uint64_t last_len = 0;
+
+    system->consistent = true;
+
+    for(uint64_t j = 0; j < n && system->consistent; j++) {
+        //Where each bit of init ends up in the CRC.
+        if(j == 0 || samples[j].len != last_len) {
+            uint64_t xp = crc_combine_constant(params, samples[j].len);
+
+            for(uint8_t b = 0; b < w; b++) {
+                uint64_t init = (uint64_t)1 << b;
+                init = params->refout ? reflect_bits(init, w) : init;
+                columns[b] = crc_combine(params, init, 0, xp);
+            }
+
+            last_len = samples[j].len;
+        }
+
+        uint64_t s = samples[j].crc ^ crc0[j];
+
+        for(uint8_t k = 0; k < w; k++) {
+            equation_t e = {0, (uint64_t)1 << k, (s >> k) & 1};
+
+            for(uint8_t b = 0; b < w; b++) {
+                e.lo |= ((columns[b] >> k) & 1) << b;
+            }
+
+            system_add(system, e);
+        }
+    }
+}
+
+/* Add the candidates with the polynomial of the catalogue entry base and the
+   reflections of params. */
+static uint64_t identify_candidates(system_t const *system, params_t *params, uint64_t base, crc_candidate_t *found) {
+    crc_model_t const *model = &crc_catalogue[base];
+    uint64_t count = 0;
+    uint8_t free_bits = 2 * params->width - system->rank;
+    bool same = false;
+
+    for(uint64_t i = base; i < crc_catalogue_size; i++) {
+        crc_model_t const *m = &crc_catalogue[i];
+
+        if(m->width != model->width || m->poly != model->poly || m->refin != params->refin || m->refout != params->refout) {
+            continue;
+        }
+
+        if(system_satisfied(system, m->init, m->xorout)) {
+            found[count++] = (crc_candidate_t){*m, true, free_bits};
+        }
+
+        //Prefer the values of the first entry with the same reflections.
+        if(!same) {
+            model = m;
+            same = true;
+        }
+    }
+
+    if(count > 0) {
+        return count;
+    }
+
+    //Solve for the init and xorout that are closest to the entry's.
+    crc_candidate_t candidate = {*model, false, free_bits};
+    candidate.model.refin = params->refin;
+    candidate.model.refout = params->refout;
+    system_solve(system, &candidate.model.init, &candidate.model.xorout);
+
+    uint8_t error;
+    params_t solved = crc_params(model->width, model->poly, candidate.model.init, params->refin, params->refout, candidate.model.xorout, 0, &error);
+    candidate.model.check = crc_table(&solved, solved.init, (unsigned char const*) "123456789", 9);
+
+    found[0] = candidate;
+    return 1;
+}
+
+/* A polynomial of the catalogue with refin and refout both set to refin. init
+   and xorout are 0. base is the first catalogue entry with the polynomial. */
+typedef struct {
+    uint64_t base;
+    params_t params;
+} config_t;
+
+/* List the polynomials to try. Returns the number of configurations. */
+static uint64_t identify_configs(crc_sample_t const *samples, uint64_t n, config_t *configs) {
+    uint64_t count = 0;
+
+    for(uint64_t i = 0; i < crc_catalogue_size; i++) {
+        crc_model_t const *model = &crc_catalogue[i];
+        bool skip = false;
+
+        //Each polynomial is tried once.
+        for(uint64_t j = 0; j < i && !skip; j++) {
+            skip = crc_catalogue[j].width == model->width && crc_catalogue[j].poly == model->poly;
+        }
+
+        //CRCs wider than the model rule it out.
+        for(uint64_t j = 0; j < n && !skip; j++) {
+            skip = model->width < 64 && samples[j].crc >> model->width;
+        }
+
+        if(skip) {
+            continue;
+        }
+
+        for(uint8_t refin = 0; refin < 2; refin++) {
+            uint8_t error;
+            configs[count].base = i;
+            configs[count].params = crc_params(model->width, model->poly, 0, refin, refin, 0, 0, &error);
+            count++;
+        }
+    }
+
+    return count;
+}
+
+/* Compute the CRC of every sample with every configuration in a single pass over
+   the samples. Each chunk of a sample is read from memory once and then passed
+   to all the configurations while it's in the cache. The CRC of sample j with
+   configuration c is stored in crcs[c * n + j]. */
+static void identify_crcs(crc_sample_t const *samples, uint64_t n, config_t *configs, uint64_t m, uint64_t *crcs) {
+    for(uint64_t j = 0; j < n; j++) {
+        for(uint64_t c = 0; c < m; c++) {
+            crcs[c * n + j] = 0;
+        }
+
+        for(uint64_t offset = 0; offset < samples[j].len; offset += IDENTIFY_CHUNK) {
+            uint64_t len = samples[j].len - offset < IDENTIFY_CHUNK ? samples[j].len - offset : IDENTIFY_CHUNK;
+
+            for(uint64_t c = 0; c < m; c++) {
+                crcs[c * n + j] = crc_calc(&configs[c].params, crcs[c * n + j], samples[j].buf + offset, len);
+            }
+        }
+    }
+}
+
+uint64_t crc_identify(crc_sample_t const *samples, uint64_t n, crc_candidate_t *candidates, uint64_t max) {
+    //Each configuration adds its exact matches or one other candidate for each refout.
+    crc_candidate_t *found = (crc_candidate_t*) malloc(4 * crc_catalogue_size * sizeof(crc_candidate_t));
+    config_t *configs = (config_t*) malloc(2 * crc_catalogue_size * sizeof(config_t));
+    uint64_t *crcs = (uint64_t*) malloc(2 * crc_catalogue_size * (n ? n : 1) * sizeof(uint64_t));
+    uint64_t *crc1 = (uint64_t*) malloc((n ? n : 1) * sizeof(uint64_t));
+    system_t *system = (system_t*) malloc(sizeof(system_t));
+    uint64_t count = 0;
+
+    if(found == NULL || configs == NULL || crcs == NULL || crc1 == NULL || system == NULL) {
+        free(found);
+        free(configs);
+        free(crcs);
+        free(crc1);
+        free(system);
+        return 0;
+    }
+
+    uint64_t m = identify_configs(samples, n, configs);
+    identify_crcs(samples, n, configs, m, crcs);
+
+    for(uint64_t c = 0; c < m; c++) {
+        crc_model_t const *model = &crc_catalogue[configs[c].base];
+        bool refin = configs[c].params.refin;
+        uint64_t *crc0 = crcs + c * n;
+
+        //refout only reflects the result.
+        for(uint64_t j = 0; j < n; j++) {
+            crc1[j] = reflect_bits(crc0[j], model->width);
+        }
+
+        for(uint8_t refout = 0; refout < 2; refout++) {
+            params_t reflected;
+            params_t *p = &configs[c].params;
+
+            if(refout != refin) {
+                uint8_t error;
+                reflected = crc_params(model->width, model->poly, 0, refin, refout, 0, 0, &error);
+                p = &reflected;
+            }
+
+            *system = (system_t){0};
+            identify_system(system, p, samples, refout == refin ? crc0 : crc1, n);
+
+            if(system->consistent) {
+                count += identify_candidates(system, p, configs[c].base, found + count);
+            }
+        }
+    }
+
+    //List the exact matches first.
+    uint64_t written = 0;
+
+    for(uint8_t exact = 2; exact-- > 0;) {
+        for(uint64_t i = 0; i < count; i++) {
+            if(found[i].exact == exact && written < max) {
+                candidates[written++] = found[i];
+            }
+        }
+    }
+
+    free(found);
+    free(configs);
+    free(crcs);
+    free(crc1);
+    free(system);
+    return count;
+}
@@ -0,0 +1,53 @@
+#ifndef CRC_IDENTIFY_H
+#define CRC_IDENTIFY_H
+
+#include "crc.h"
+
+/* The parameters of a CRC model, with init and xorout given as in the catalogue. */
+typedef struct {
+    const char *name;
+    uint8_t width;
+    uint64_t poly;
+    uint64_t init;
+    bool refin;
+    bool refout;
+    uint64_t xorout;
+    uint64_t check;
+} crc_model_t;
+
+/* A message and the CRC that was received with it. */
+typedef struct {
+    unsigned char const *buf;
+    uint64_t len;
+    uint64_t crc;
+} crc_sample_t;
+
+/* A model that is consistent with every sample. If exact is true, the model is a
+   catalogue entry. Otherwise it uses the polynomial of the named entry with
+   other reflections or with init and xorout solved from the samples. free_bits
+   counts the bits of init and xorout that the samples leave undetermined. Those
+   bits are taken from the named entry. */
+typedef struct {
+    crc_model_t model;
+    bool exact;
+    uint8_t free_bits;
+} crc_candidate_t;
+
+/* The models of Greg Cook's CRC catalogue, and their number. */
+extern const crc_model_t DLL_EXPORT crc_catalogue[];
+extern const uint64_t DLL_EXPORT crc_catalogue_size;
+
+/* Find the models that produce the CRCs of all n samples. Every polynomial of
+   the catalogue is tried with each combination of refin and refout, and its init
+   and xorout are solved from the samples as a system of linear equations over
+   GF(2), so models with a non-standard init or xorout are found too. Each sample
+   gives width equations and init and xorout have 2 * width bits, so at least
+   three samples of different lengths are needed to rule out other models. The
+   samples are read from memory once, in chunks that are passed to every
+   polynomial while they're in the cache, but each polynomial still computes
+   its own CRCs, so the time is proportional to the number of polynomials times
+   the length of the samples. Exact matches are listed before the others. Up to max candidates are written to
+   candidates, and the number of candidates found is returned. */
+uint64_t DLL_EXPORT crc_identify(crc_sample_t const *samples, uint64_t n, crc_candidate_t *candidates, uint64_t max);
+
+#endif
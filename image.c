@@ -0,0 +1,196 @@
+#include <stdio.h>
+#include <string.h>
+#include "image.h"
+#include "registry.h"
+
+#ifndef DISABLE_SIMD
+#include "cpu.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* First bytes of an image file. */
+#define IMAGE_MAGIC "crcimage"
+
+/* Incremented when the layout of the header changes. Changes to params_t are
+   detected by its size. */
+#define IMAGE_VERSION 1
+
+/* Written in the byte order of the machine that wrote the image. */
+#define IMAGE_BYTE_ORDER 0x01020304
+
+/* Set in the flags if the folding constants were computed. */
+#define IMAGE_SIMD 1
+
+#ifndef DISABLE_SIMD
+#define IMAGE_FLAGS IMAGE_SIMD
+#else
+#define IMAGE_FLAGS 0
+#endif
+
+//----------------------------------------
+
+/* Image header */
+
+/* Precedes the params_t structs in the file. Its size is a multiple of 8 so
+   that the structs that follow are aligned in the mapped pages. */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;
+    uint32_t params_size;
+    uint32_t flags;
+    uint64_t count;
+    uint64_t checksum;
+} image_header_t;
+
+/* CRC-64/XZ of the params_t structs. */
+static bool image_checksum(params_t const *params, uint64_t n, uint64_t *checksum) {
+    uint8_t error;
+    params_t *xz = crc_params_get(64, 0x42f0e1eba9ea3693, 0xffffffffffffffff, true, true, 0xffffffffffffffff, 0x995dc9bbdf1939fa, &error);
+
+    if(xz == NULL) {
+        return false;
+    }
+
+    *checksum = crc_calc(xz, xz->init, (unsigned char const*) params, n * sizeof(params_t));
+    return true;
+}
+
+/* Check that the header matches this build and the size of the file. */
+static bool image_valid(image_header_t const *header, uint64_t size) {
+    return memcmp(header->magic, IMAGE_MAGIC, 8) == 0 &&
+           header->version == IMAGE_VERSION &&
+           header->byte_order == IMAGE_BYTE_ORDER &&
+           header->params_size == sizeof(params_t) &&
+           header->flags == IMAGE_FLAGS &&
+           header->count <= (size - sizeof(image_header_t)) / sizeof(params_t) &&
+           size == sizeof(image_header_t) + header->count * sizeof(params_t);
+}
+
+//----------------------------------------
+
+/* Image files */
+
+bool crc_params_save(params_t const *params, uint64_t n, const char *path) {
+    image_header_t header = {0};
+
+    memcpy(header.magic, IMAGE_MAGIC, 8);
+    header.version = IMAGE_VERSION;
+    header.byte_order = IMAGE_BYTE_ORDER;
+    header.params_size = sizeof(params_t);
+    header.flags = IMAGE_FLAGS;
+    header.count = n;
+
+    if(!image_checksum(params, n, &header.checksum)) {
+        return false;
+    }
+
+    FILE *file = fopen(path, "wb");
+
+    if(file == NULL) {
+        return false;
+    }
+
+    bool valid = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(params, sizeof(params_t), n, file) == n;
+
+    return fclose(file) == 0 && valid;
+}
+
+/* Map a whole file read-only. Returns NULL on failure or if the file is too
+   small to hold a header. */
+static void *image_map_file(const char *path, uint64_t *size) {
+    #ifdef _WIN32
+    HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+
+    if(file == INVALID_HANDLE_VALUE) {
+        return NULL;
+    }
+
+    LARGE_INTEGER file_size;
+    void *view = NULL;
+
+    if(GetFileSizeEx(file, &file_size) && (uint64_t)file_size.QuadPart >= sizeof(image_header_t)) {
+        //The view keeps the mapping open after its handle is closed.
+        HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+
+        if(mapping != NULL) {
+            view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+            CloseHandle(mapping);
+        }
+
+        *size = file_size.QuadPart;
+    }
+
+    CloseHandle(file);
+    return view;
+
+    #else
+    int fd = open(path, O_RDONLY);
+
+    if(fd < 0) {
+        return NULL;
+    }
+
+    struct stat st;
+    void *view = NULL;
+
+    if(fstat(fd, &st) == 0 && (uint64_t)st.st_size >= sizeof(image_header_t)) {
+        view = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+        view = view == MAP_FAILED ? NULL : view;
+        *size = st.st_size;
+    }
+
+    close(fd);
+    return view;
+    #endif
+}
+
+static void image_unmap_file(void *view, uint64_t size) {
+    #ifdef _WIN32
+    UnmapViewOfFile(view);
+    #else
+    munmap(view, size);
+    #endif
+}
+
+params_t *crc_params_map(const char *path, uint64_t *count) {
+    //Normally called by crc_params, which is skipped.
+    #ifndef DISABLE_SIMD
+    cpu_check_features();
+    #endif
+
+    uint64_t size;
+    void *view = image_map_file(path, &size);
+
+    if(view == NULL) {
+        return NULL;
+    }
+
+    image_header_t const *header = (image_header_t const*) view;
+    params_t *params = (params_t*) ((unsigned char*) view + sizeof(image_header_t));
+    uint64_t checksum;
+
+    if(!image_valid(header, size) ||
+       !image_checksum(params, header->count, &checksum) ||
+       checksum != header->checksum) {
+        image_unmap_file(view, size);
+        return NULL;
+    }
+
+    *count = header->count;
+    return params;
+}
+
+void crc_params_unmap(params_t *params, uint64_t count) {
+    void *view = (unsigned char*) params - sizeof(image_header_t);
+    image_unmap_file(view, sizeof(image_header_t) + count * sizeof(params_t));
+}
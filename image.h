@@ -0,0 +1,23 @@
+#ifndef CRC_IMAGE_H
+#define CRC_IMAGE_H
+
+#include "crc.h"
+
+/* Write an image of n params_t structs to a file. The image holds everything
+   computed by crc_params, so that other processes can use the structs with
+   crc_params_map instead of constructing them. Images are only valid for the
+   same build of the library on machines with the same byte order. Returns false
+   on failure. */
+bool DLL_EXPORT crc_params_save(params_t const *params, uint64_t n, const char *path);
+
+/* Map an image written by crc_params_save into memory and return the params_t
+   structs in it. The structs are used in place, so processes that map the same
+   file share its pages. They are read-only and must not be modified. count is
+   set to the number of structs. Returns NULL if the file is missing or the
+   header or checksum of the image is invalid. */
+params_t DLL_EXPORT *crc_params_map(const char *path, uint64_t *count);
+
+/* Unmap an image returned by crc_params_map. */
+void DLL_EXPORT crc_params_unmap(params_t *params, uint64_t count);
+
+#endif
@@ -0,0 +1,292 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "index.h"
+
+/* First bytes of an index file. The last byte is the version of the format. */
+#define INDEX_MAGIC "crcindx1"
+
+/* Number of 64-bit fields that follow the magic in an index file. */
+#define INDEX_FIELDS 8
+
+//----------------------------------------
+
+/* Index structures */
+
+/* The CRCs of level k cover 2^k blocks each. Level 0 holds the CRCs of the
+   blocks and the last level holds the CRC of the whole buffer. */
+struct crc_index {
+    params_t *params;
+    uint64_t len;
+    uint64_t block;
+    uint64_t blocks;
+    uint8_t levels;
+    uint64_t offsets[64]; //Position of each level in crcs.
+    uint64_t counts[64];  //Number of CRCs in each level.
+    uint64_t xp[64];      //Combine constant of a node of each level that covers 2^k full blocks.
+    uint64_t *crcs;
+};
+
+//----------------------------------------
+
+/* Index construction */
+
+/* Number of bytes covered by the i-th node of level k. */
+static uint64_t node_len(crc_index_t *index, uint8_t k, uint64_t i) {
+    uint64_t start = (i << k) * index->block;
+    uint64_t end = ((i + 1) << k) * index->block;
+    return (end < index->len ? end : index->len) - start;
+}
+
+/* Combine constant of the i-th node of level k. Only the last node of a level
+   can be shorter than 2^k blocks. */
+static uint64_t node_xp(crc_index_t *index, uint8_t k, uint64_t i) {
+    uint64_t len = node_len(index, k, i);
+    return len == index->block << k ? index->xp[k] : crc_combine_constant(index->params, len);
+}
+
+/* Allocate an index and lay out its levels. */
+static crc_index_t *index_alloc(params_t *params, uint64_t len, uint64_t block) {
+    if(block == 0) {
+        return NULL;
+    }
+
+    crc_index_t *index = (crc_index_t*) calloc(1, sizeof(crc_index_t));
+
+    if(index == NULL) {
+        return NULL;
+    }
+
+    index->params = params;
+    index->len = len;
+    index->block = block;
+    index->blocks = len / block + (len % block != 0);
+
+    uint64_t total = 0;
+    uint64_t count = index->blocks;
+
+    while(count > 0) {
+        index->offsets[index->levels] = total;
+        index->counts[index->levels] = count;
+        index->xp[index->levels] = crc_combine_constant(params, block << index->levels);
+        index->levels++;
+        total += count;
+        count = count > 1 ? (count + 1) / 2 : 0;
+    }
+
+    index->crcs = (uint64_t*) malloc((total ? total : 1) * sizeof(uint64_t));
+
+    if(index->crcs == NULL) {
+        free(index);
+        return NULL;
+    }
+
+    return index;
+}
+
+/* Compute the CRCs of the levels above the blocks. */
+static void index_build_tree(crc_index_t *index) {
+    for(uint8_t k = 1; k < index->levels; k++) {
+        uint64_t *children = index->crcs + index->offsets[k - 1];
+        uint64_t *parents = index->crcs + index->offsets[k];
+
+        for(uint64_t i = 0; i < index->counts[k]; i++) {
+            if(2 * i + 1 < index->counts[k - 1]) {
+                uint64_t xp = node_xp(index, k - 1, 2 * i + 1);
+                parents[i] = crc_combine(index->params, children[2 * i], children[2 * i + 1], xp);
+            } else {
+                parents[i] = children[2 * i];
+            }
+        }
+    }
+}
+
+crc_index_t *crc_index_build(params_t *params, unsigned char const *buf, uint64_t len, uint64_t block) {
+    crc_index_t *index = index_alloc(params, len, block);
+
+    if(index == NULL) {
+        return NULL;
+    }
+
+    for(uint64_t i = 0; i < index->blocks; i++) {
+        index->crcs[i] = crc_calc(params, params->init, buf + i * block, node_len(index, 0, i));
+    }
+
+    index_build_tree(index);
+    return index;
+}
+
+void crc_index_free(crc_index_t *index) {
+    free(index->crcs);
+    free(index);
+}
+
+//----------------------------------------
+
+/* Index queries */
+
+/* Append the CRC of a partial block to crc. */
+static uint64_t range_partial(crc_index_t *index, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    params_t *params = index->params;
+
+    if(len == 0) {
+        return crc;
+    }
+
+    uint64_t crc2 = crc_calc(params, params->init, buf, len);
+    return crc_combine(params, crc, crc2, crc_combine_constant(params, len));
+}
+
+/* Find the highest level with a node that starts at block i and doesn't go past
+   the last block. */
+static uint8_t range_level(crc_index_t *index, uint64_t i, uint64_t last) {
+    uint8_t k = 0;
+
+    while(k + 1 < index->levels) {
+        uint64_t size = (uint64_t)1 << (k + 1);
+        uint64_t end = i + size < index->blocks ? i + size : index->blocks;
+
+        if((i & (size - 1)) != 0 || end > last) {
+            break;
+        }
+
+        k++;
+    }
+
+    return k;
+}
+
+uint64_t crc_range(crc_index_t *index, unsigned char const *buf, uint64_t offset, uint64_t len) {
+    params_t *params = index->params;
+    uint64_t block = index->block;
+    uint64_t end = offset + len;
+
+    //The whole blocks inside the range. The last block is whole if the range reaches its end.
+    uint64_t first = offset / block + (offset % block != 0);
+    uint64_t last = end == index->len ? index->blocks : end / block;
+
+    if(first >= last) {
+        return crc_calc(params, params->init, buf + offset, len);
+    }
+
+    uint64_t crc = range_partial(index, params->init, buf + offset, first * block - offset);
+    uint64_t i = first;
+
+    while(i < last) {
+        uint8_t k = range_level(index, i, last);
+        crc = crc_combine(params, crc, index->crcs[index->offsets[k] + (i >> k)], node_xp(index, k, i >> k));
+        i += (uint64_t)1 << k;
+    }
+
+    if(last < index->blocks) {
+        crc = range_partial(index, crc, buf + last * block, end - last * block);
+    }
+
+    return crc;
+}
+
+//----------------------------------------
+
+/* Index files */
+
+/* Integers are stored in little-endian order regardless of the machine. */
+static bool write_u64(FILE *file, uint64_t value) {
+    unsigned char bytes[8];
+
+    for(uint8_t i = 0; i < 8; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+
+    return fwrite(bytes, 1, 8, file) == 8;
+}
+
+static bool read_u64(FILE *file, uint64_t *value) {
+    unsigned char bytes[8];
+
+    if(fread(bytes, 1, 8, file) != 8) {
+        return false;
+    }
+
+    *value = 0;
+    for(uint8_t i = 0; i < 8; i++) {
+        *value |= (uint64_t)bytes[i] << (8 * i);
+    }
+
+    return true;
+}
+
+/* The parameters of the CRC followed by the layout of the index. */
+static void index_fields(params_t *params, uint64_t len, uint64_t block, uint64_t *fields) {
+    fields[0] = params->width;
+    fields[1] = params->poly;
+    fields[2] = params->init;
+    fields[3] = params->refin;
+    fields[4] = params->refout;
+    fields[5] = params->xorout;
+    fields[6] = len;
+    fields[7] = block;
+}
+
+bool crc_index_save(crc_index_t *index, const char *path) {
+    FILE *file = fopen(path, "wb");
+
+    if(file == NULL) {
+        return false;
+    }
+
+    uint64_t fields[INDEX_FIELDS];
+    index_fields(index->params, index->len, index->block, fields);
+
+    bool valid = fwrite(INDEX_MAGIC, 1, 8, file) == 8;
+
+    for(uint8_t i = 0; i < INDEX_FIELDS && valid; i++) {
+        valid = write_u64(file, fields[i]);
+    }
+
+    for(uint64_t i = 0; i < index->blocks && valid; i++) {
+        valid = write_u64(file, index->crcs[i]);
+    }
+
+    return fclose(file) == 0 && valid;
+}
+
+crc_index_t *crc_index_load(params_t *params, const char *path) {
+    FILE *file = fopen(path, "rb");
+
+    if(file == NULL) {
+        return NULL;
+    }
+
+    char magic[8];
+    uint64_t fields[INDEX_FIELDS];
+    bool valid = fread(magic, 1, 8, file) == 8 && memcmp(magic, INDEX_MAGIC, 8) == 0;
+
+    for(uint8_t i = 0; i < INDEX_FIELDS && valid; i++) {
+        valid = read_u64(file, &fields[i]);
+    }
+
+    //Reject files written with different parameters.
+    uint64_t expected[INDEX_FIELDS];
+
+    if(valid) {
+        index_fields(params, fields[6], fields[7], expected);
+        valid = memcmp(fields, expected, sizeof(fields)) == 0;
+    }
+
+    crc_index_t *index = valid ? index_alloc(params, fields[6], fields[7]) : NULL;
+
+    for(uint64_t i = 0; index != NULL && i < index->blocks; i++) {
+        if(!read_u64(file, &index->crcs[i])) {
+            crc_index_free(index);
+            index = NULL;
+        }
+    }
+
+    fclose(file);
+
+    if(index != NULL) {
+        index_build_tree(index);
+    }
+
+    return index;
+}
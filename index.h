@@ -0,0 +1,34 @@
+#ifndef CRC_INDEX_H
+#define CRC_INDEX_H
+
+#include "crc.h"
+
+/* The CRCs of the fixed-size blocks of a buffer, and of every pair, quad, etc. of
+   consecutive blocks, arranged in a binary tree. The CRC of any range of the
+   buffer is found by joining O(log n) stored CRCs with crc_combine, so only the
+   partial blocks at the ends of the range are read. */
+typedef struct crc_index crc_index_t;
+
+/* Build an index of buf using blocks of block bytes. The last block may be
+   shorter. params must remain valid until the index is freed. Returns NULL if
+   block is 0 or the index couldn't be allocated. */
+crc_index_t DLL_EXPORT *crc_index_build(params_t *params, unsigned char const *buf, uint64_t len, uint64_t block);
+
+/* Release an index returned by crc_index_build or crc_index_load. */
+void DLL_EXPORT crc_index_free(crc_index_t *index);
+
+/* Return the CRC of the len bytes of buf starting at offset. buf is the indexed
+   buffer, of which at most two partial blocks are read. It may be NULL if the
+   range begins and ends on block boundaries or at the end of the buffer. The
+   range must lie within the indexed buffer. */
+uint64_t DLL_EXPORT crc_range(crc_index_t *index, unsigned char const *buf, uint64_t offset, uint64_t len);
+
+/* Write the block CRCs of an index to a file. The parent CRCs are rebuilt by
+   crc_index_load without reading the buffer. Returns false on failure. */
+bool DLL_EXPORT crc_index_save(crc_index_t *index, const char *path);
+
+/* Read an index written by crc_index_save. Returns NULL if the file is missing
+   or invalid, or if it was written with different CRC parameters. */
+crc_index_t DLL_EXPORT *crc_index_load(params_t *params, const char *path);
+
+#endif
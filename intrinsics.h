@@ -9,9 +9,33 @@
 #define ALIGN_ARRAY __declspec(align(16))
 #endif
 
-const char ALIGN_ARRAY SWAP_TABLE[] = {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+//Target attributes for the functions that use CLMUL and the table lookups.
+#ifdef __GNUC__
+#define ALWAYS_INLINE inline __attribute__((always_inline))
+#ifdef __x86_64__
+#define TARGET_ATTRIBUTE __attribute__((target("sse4.1,pclmul")))
+#define SHUFFLE_TARGET_ATTRIBUTE __attribute__((target("ssse3")))
+#elif __aarch64__
+#define TARGET_ATTRIBUTE __attribute__((target("+aes")))
+#define SHUFFLE_TARGET_ATTRIBUTE
+#else
+#error "Unsupported Architecture. Compile on x86-64 or aarch64 or use DISABLE_SIMD."
+#endif
+#elif _MSC_VER
+#if defined(_M_AMD64) || defined(_M_ARM64)
+#define ALWAYS_INLINE __forceinline
+#define TARGET_ATTRIBUTE
+#define SHUFFLE_TARGET_ATTRIBUTE
+#else
+#error "Unsupported Architecture. Compile on x86-64 or aarch64 or use DISABLE_SIMD."
+#endif
+#else
+#error "Unsupported Compiler. Use GCC, Clang, or MSVC."
+#endif
 
-const char ALIGN_ARRAY SHL_TABLE[][16] = {
+static const char ALIGN_ARRAY SWAP_TABLE[] = {15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0};
+
+static const char ALIGN_ARRAY SHL_TABLE[][16] = {
     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
     {-1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14},
     {-1, -1,  0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13},
@@ -30,7 +54,7 @@ const char ALIGN_ARRAY SHL_TABLE[][16] = {
     {-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  0}
 };
 
-const char ALIGN_ARRAY SHR_TABLE[][16] = {
+static const char ALIGN_ARRAY SHR_TABLE[][16] = {
     { 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15},
     { 1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, -1},
     { 2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, -1, -1},
@@ -98,6 +122,22 @@ typedef __m128i uint128_t;
 //XOR two 128-bit integers.
 #define intrin_xor(a, b) _mm_xor_si128(a, b)
 
+//Store a 128-bit integer into 16 bytes at ptr.
+#define intrin_storeu_le(ptr, x) _mm_storeu_si128((__m128i*)(ptr), x)
+
+//Look up each byte of i in the 16 byte table t. Requires SSSE3.
+#define intrin_lookup(t, i) _mm_shuffle_epi8(t, i)
+
+//Interleave the low 8 bytes of a and b.
+#define intrin_unpacklo_8(a, b) _mm_unpacklo_epi8(a, b)
+
+//Interleave the high 8 bytes of a and b.
+#define intrin_unpackhi_8(a, b) _mm_unpackhi_epi8(a, b)
+
+//Low and high 4 bits of each byte.
+#define intrin_nibble_lo(x) _mm_and_si128(x, _mm_set1_epi8(0x0f))
+#define intrin_nibble_hi(x) _mm_and_si128(_mm_srli_epi16(x, 4), _mm_set1_epi8(0x0f))
+
 //----------------------------------------
 
 #elif defined(__aarch64__) || defined(_M_ARM64)
@@ -147,6 +187,22 @@ typedef uint64x2_t uint128_t;
 //XOR two 64x2 vectors.
 #define intrin_xor(a, b) veorq_u64(a, b)
 
+//Store a 64x2 vector into 16 bytes at ptr.
+#define intrin_storeu_le(ptr, x) vst1q_u64((uint64_t*)(ptr), x)
+
+//Look up each byte of i in the 16 byte table t.
+#define intrin_lookup(t, i) vreinterpretq_u64_u8(vqtbl1q_u8(vreinterpretq_u8_u64(t), vreinterpretq_u8_u64(i)))
+
+//Interleave the low 8 bytes of a and b.
+#define intrin_unpacklo_8(a, b) vreinterpretq_u64_u8(vzip1q_u8(vreinterpretq_u8_u64(a), vreinterpretq_u8_u64(b)))
+
+//Interleave the high 8 bytes of a and b.
+#define intrin_unpackhi_8(a, b) vreinterpretq_u64_u8(vzip2q_u8(vreinterpretq_u8_u64(a), vreinterpretq_u8_u64(b)))
+
+//Low and high 4 bits of each byte.
+#define intrin_nibble_lo(x) vreinterpretq_u64_u8(vandq_u8(vreinterpretq_u8_u64(x), vdupq_n_u8(0x0f)))
+#define intrin_nibble_hi(x) vreinterpretq_u64_u8(vshrq_n_u8(vreinterpretq_u8_u64(x), 4))
+
 //----------------------------------------
 
 #else
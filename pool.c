@@ -0,0 +1,439 @@
+#include <stdlib.h>
+#include "pool.h"
+#include "thread.h"
+
+/* Default length of the sub-ranges that large buffers are divided into. */
+#define POOL_SPLIT ((uint64_t)1 << 20)
+
+/* Maximum number of small tasks that a worker takes from its queue at once. */
+#define POOL_BATCH 16
+
+//----------------------------------------
+
+/* Pool structures */
+
+/* A sub-range of a job. Small jobs consist of a single task. */
+typedef struct {
+    crc_job_t *job;
+    uint64_t index;
+} task_t;
+
+/* Growable ring buffer of tasks. */
+typedef struct {
+    task_t *tasks;
+    uint64_t head;
+    uint64_t count;
+    uint64_t size;
+} queue_t;
+
+/* Each worker owns two queues. Small jobs are kept apart from the sub-ranges
+   of large jobs so that they don't wait behind them. Other workers steal from
+   the back of the queues when their own are empty. */
+typedef struct {
+    crc_pool_t *pool;
+    mutex_t lock;
+    queue_t small;
+    queue_t bulk;
+    thread_t thread;
+    uint32_t id;
+} worker_t;
+
+struct crc_pool {
+    worker_t *workers;
+    uint32_t threads;
+    uint64_t split;
+
+    /* Idle workers sleep on work. The lock protects stop and orders the
+       wakeups with the checks of pending. It isn't taken for each task. */
+    mutex_t lock;
+    cond_t work;
+    bool stop;
+
+    /* Number of tasks that were queued but not taken by a worker yet. Atomic. */
+    uint64_t pending;
+
+    /* Worker that receives the next task. Atomic. */
+    uint64_t next;
+};
+
+struct crc_job {
+    crc_pool_t *pool;
+    params_t *params;
+    unsigned char const *buf;
+    uint64_t len;
+    uint64_t crc;
+    uint64_t parts;
+    uint64_t remaining; //Atomic.
+    uint64_t *crcs;
+    uint64_t *lens;
+    crc_callback_t callback;
+    void *arg;
+
+    /* Waiters of the job sleep on its own condition, so finishing a job only
+       wakes the threads that wait for it. signaled is protected by the lock.
+       done is atomic and set after the finishing thread has released the lock,
+       so a job that is seen as done can be freed. */
+    mutex_t lock;
+    cond_t finished;
+    bool signaled;
+    uint64_t done;
+};
+
+//----------------------------------------
+
+/* Queue functions */
+
+/* Append a task to the back of the queue. Returns false if the queue couldn't grow. */
+static bool queue_push(queue_t *queue, task_t task) {
+    if(queue->count == queue->size) {
+        uint64_t size = queue->size ? queue->size * 2 : 64;
+        task_t *tasks = (task_t*) malloc(size * sizeof(task_t));
+
+        if(tasks == NULL) {
+            return false;
+        }
+
+        for(uint64_t i = 0; i < queue->count; i++) {
+            tasks[i] = queue->tasks[(queue->head + i) % queue->size];
+        }
+
+        free(queue->tasks);
+        queue->tasks = tasks;
+        queue->head = 0;
+        queue->size = size;
+    }
+
+    queue->tasks[(queue->head + queue->count) % queue->size] = task;
+    queue->count++;
+    return true;
+}
+
+/* Remove a task from the front of the queue. */
+static task_t queue_pop_front(queue_t *queue) {
+    task_t task = queue->tasks[queue->head];
+    queue->head = (queue->head + 1) % queue->size;
+    queue->count--;
+    return task;
+}
+
+/* Remove a task from the back of the queue. */
+static task_t queue_pop_back(queue_t *queue) {
+    queue->count--;
+    return queue->tasks[(queue->head + queue->count) % queue->size];
+}
+
+//----------------------------------------
+
+/* Job execution */
+
+/* Release the memory and the wait objects of a job. */
+static void job_free(crc_job_t *job) {
+    cond_destroy(&job->finished);
+    mutex_destroy(&job->lock);
+    free(job->crcs);
+    free(job);
+}
+
+/* Publish the CRC of a job and wake up anyone waiting for it. */
+static void job_finish(crc_job_t *job, uint64_t crc) {
+    if(job->callback) {
+        job->callback(crc, job->arg);
+        job_free(job);
+        return;
+    }
+
+    mutex_lock(&job->lock);
+    job->crc = crc;
+    job->signaled = true;
+    cond_broadcast(&job->finished);
+    mutex_unlock(&job->lock);
+
+    atomic_store64(&job->done, 1);
+}
+
+/* Compute the CRC of one sub-range. The worker that computes the last
+   remaining sub-range of a job joins the results. */
+static void task_run(task_t task) {
+    crc_job_t *job = task.job;
+    crc_pool_t *pool = job->pool;
+
+    if(job->parts == 1) {
+        job_finish(job, crc_calc(job->params, job->crc, job->buf, job->len));
+        return;
+    }
+
+    uint64_t offset = task.index * pool->split;
+    uint64_t len = job->lens[task.index];
+    uint64_t crc = task.index == 0 ? job->crc : job->params->init;
+
+    job->crcs[task.index] = crc_calc(job->params, crc, job->buf + offset, len);
+
+    //The counter orders the CRCs of the other sub-ranges before the join.
+    if(atomic_add64(&job->remaining, (uint64_t)-1) == 1) {
+        job_finish(job, crc_combine_many(job->params, job->crcs, job->lens, job->parts));
+    }
+}
+
+/* Take tasks from the worker's own queues. Several small tasks are taken at once
+   as long as they add up to less than the split length. */
+static uint32_t worker_take(worker_t *worker, task_t *tasks) {
+    uint32_t n = 0;
+    uint64_t bytes = 0;
+
+    mutex_lock(&worker->lock);
+
+    while(worker->small.count > 0 && n < POOL_BATCH && bytes < worker->pool->split) {
+        tasks[n] = queue_pop_front(&worker->small);
+        bytes += tasks[n].job->len;
+        n++;
+    }
+
+    if(n == 0 && worker->bulk.count > 0) {
+        tasks[n++] = queue_pop_front(&worker->bulk);
+    }
+
+    mutex_unlock(&worker->lock);
+    return n;
+}
+
+/* Steal a task from the back of another worker's queues. */
+static uint32_t worker_steal(worker_t *worker, task_t *tasks) {
+    crc_pool_t *pool = worker->pool;
+
+    for(uint32_t i = 1; i < pool->threads; i++) {
+        worker_t *victim = &pool->workers[(worker->id + i) % pool->threads];
+        uint32_t n = 0;
+
+        mutex_lock(&victim->lock);
+
+        if(victim->bulk.count > 0) {
+            tasks[n++] = queue_pop_back(&victim->bulk);
+        } else if(victim->small.count > 0) {
+            tasks[n++] = queue_pop_back(&victim->small);
+        }
+
+        mutex_unlock(&victim->lock);
+
+        if(n > 0) {
+            return n;
+        }
+    }
+
+    return 0;
+}
+
+static THREAD_FUNC worker_main(void *arg) {
+    worker_t *worker = (worker_t*) arg;
+    crc_pool_t *pool = worker->pool;
+    task_t tasks[POOL_BATCH];
+
+    while(true) {
+        uint32_t n = worker_take(worker, tasks);
+
+        if(n == 0) {
+            n = worker_steal(worker, tasks);
+        }
+
+        if(n > 0) {
+            atomic_add64(&pool->pending, -(uint64_t)n);
+
+            for(uint32_t i = 0; i < n; i++) {
+                task_run(tasks[i]);
+            }
+            continue;
+        }
+
+        mutex_lock(&pool->lock);
+        while(atomic_load64(&pool->pending) == 0 && !pool->stop) {
+            cond_wait(&pool->work, &pool->lock);
+        }
+        bool stop = atomic_load64(&pool->pending) == 0 && pool->stop;
+        mutex_unlock(&pool->lock);
+
+        if(stop) {
+            break;
+        }
+
+        //A task was counted but is still being queued by the submitter.
+        thread_yield();
+    }
+
+    return THREAD_RETURN;
+}
+
+//----------------------------------------
+
+/* Pool interface */
+
+crc_pool_t *crc_pool_create(uint32_t threads, uint64_t split) {
+    crc_pool_t *pool = (crc_pool_t*) calloc(1, sizeof(crc_pool_t));
+
+    if(pool == NULL) {
+        return NULL;
+    }
+
+    pool->threads = threads ? threads : thread_cpu_count();
+    pool->split = split ? split : POOL_SPLIT;
+    pool->workers = (worker_t*) calloc(pool->threads, sizeof(worker_t));
+
+    if(pool->workers == NULL) {
+        free(pool);
+        return NULL;
+    }
+
+    mutex_init(&pool->lock);
+    cond_init(&pool->work);
+
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        worker_t *worker = &pool->workers[i];
+        worker->pool = pool;
+        worker->id = i;
+        mutex_init(&worker->lock);
+    }
+
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        if(!thread_create(&pool->workers[i].thread, worker_main, &pool->workers[i])) {
+            //Destroy the locks of the workers that weren't started, then
+            //stop the threads that were.
+            for(uint32_t j = i; j < pool->threads; j++) {
+                mutex_destroy(&pool->workers[j].lock);
+            }
+
+            pool->threads = i;
+            crc_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+}
+
+void crc_pool_destroy(crc_pool_t *pool) {
+    mutex_lock(&pool->lock);
+    pool->stop = true;
+    cond_broadcast(&pool->work);
+    mutex_unlock(&pool->lock);
+
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        thread_join(pool->workers[i].thread);
+    }
+
+    for(uint32_t i = 0; i < pool->threads; i++) {
+        mutex_destroy(&pool->workers[i].lock);
+        free(pool->workers[i].small.tasks);
+        free(pool->workers[i].bulk.tasks);
+    }
+
+    cond_destroy(&pool->work);
+    mutex_destroy(&pool->lock);
+    free(pool->workers);
+    free(pool);
+}
+
+/* Allocate a job and distribute its tasks among the workers. */
+static crc_job_t *pool_submit(crc_pool_t *pool, params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, crc_callback_t callback, void *arg) {
+    crc_job_t *job = (crc_job_t*) calloc(1, sizeof(crc_job_t));
+
+    if(job == NULL) {
+        return NULL;
+    }
+
+    job->pool = pool;
+    job->params = params;
+    job->buf = buf;
+    job->len = len;
+    job->crc = crc;
+    job->parts = len > pool->split ? (len + pool->split - 1) / pool->split : 1;
+    job->remaining = job->parts;
+    job->callback = callback;
+    job->arg = arg;
+
+    if(job->parts > 1) {
+        job->crcs = (uint64_t*) malloc(2 * job->parts * sizeof(uint64_t));
+
+        if(job->crcs == NULL) {
+            free(job);
+            return NULL;
+        }
+
+        //The sub-ranges are joined with crc_combine_many, which takes their lengths.
+        job->lens = job->crcs + job->parts;
+        for(uint64_t i = 0; i < job->parts; i++) {
+            job->lens[i] = i < job->parts - 1 ? pool->split : len - i * pool->split;
+        }
+    }
+
+    mutex_init(&job->lock);
+    cond_init(&job->finished);
+
+    uint64_t next = atomic_add64(&pool->next, job->parts);
+    atomic_add64(&pool->pending, job->parts);
+
+    /* The job may finish as soon as its last task is queued, and a job with a
+       callback is freed when it finishes. */
+    uint64_t parts = job->parts;
+    uint64_t failed = 0;
+
+    for(uint64_t i = 0; i < parts; i++) {
+        worker_t *worker = &pool->workers[(next + i) % pool->threads];
+        task_t task = {job, i};
+
+        mutex_lock(&worker->lock);
+        bool queued = queue_push(parts > 1 ? &worker->bulk : &worker->small, task);
+        mutex_unlock(&worker->lock);
+
+        //Compute the task on the calling thread if it couldn't be queued.
+        if(!queued) {
+            failed++;
+            task_run(task);
+        }
+    }
+
+    atomic_add64(&pool->pending, -failed);
+
+    /* Signal under the lock, so that a worker that found no pending tasks is
+       already waiting. This is once per job, not per task. */
+    mutex_lock(&pool->lock);
+    if(parts - failed == 1) {
+        cond_signal(&pool->work);
+    } else if(parts - failed > 1) {
+        cond_broadcast(&pool->work);
+    }
+    mutex_unlock(&pool->lock);
+
+    return job;
+}
+
+crc_job_t *crc_pool_submit(crc_pool_t *pool, params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len) {
+    return pool_submit(pool, params, crc, buf, len, NULL, NULL);
+}
+
+bool crc_pool_submit_callback(crc_pool_t *pool, params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, crc_callback_t callback, void *arg) {
+    return pool_submit(pool, params, crc, buf, len, callback, arg) != NULL;
+}
+
+uint64_t crc_job_wait(crc_job_t *job) {
+    if(!atomic_load64(&job->done)) {
+        mutex_lock(&job->lock);
+        while(!job->signaled) {
+            cond_wait(&job->finished, &job->lock);
+        }
+        mutex_unlock(&job->lock);
+
+        //The finishing thread is about to set done after unlocking.
+        while(!atomic_load64(&job->done)) {
+            thread_yield();
+        }
+    }
+
+    //The CRC is written before done is set.
+    return job->crc;
+}
+
+bool crc_job_done(crc_job_t *job) {
+    return atomic_load64(&job->done) != 0;
+}
+
+void crc_job_free(crc_job_t *job) {
+    job_free(job);
+}
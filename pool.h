@@ -0,0 +1,42 @@
+#ifndef CRC_POOL_H
+#define CRC_POOL_H
+
+#include "crc.h"
+
+/* A persistent pool of worker threads that compute CRCs in the background. */
+typedef struct crc_pool crc_pool_t;
+
+/* A pending CRC computation. Returned by crc_pool_submit. */
+typedef struct crc_job crc_job_t;
+
+/* Called on a worker thread with the CRC of a job submitted by crc_pool_submit_callback. */
+typedef void (*crc_callback_t)(uint64_t crc, void *arg);
+
+/* Start a pool with the specified number of threads, or one thread per processor
+   if threads is 0. Buffers longer than split bytes are divided into sub-ranges
+   of split bytes that are computed in parallel and joined with crc_combine. A
+   split of 0 selects the default of 1 MiB. Returns NULL on failure. */
+crc_pool_t DLL_EXPORT *crc_pool_create(uint32_t threads, uint64_t split);
+
+/* Finish the remaining jobs and stop the pool's threads. */
+void DLL_EXPORT crc_pool_destroy(crc_pool_t *pool);
+
+/* Queue the CRC computation of buf. params and buf must remain valid until the
+   job is done. The returned job must be released with crc_job_free after it is
+   done. Returns NULL if the job couldn't be allocated. */
+crc_job_t DLL_EXPORT *crc_pool_submit(crc_pool_t *pool, params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len);
+
+/* Queue the CRC computation of buf and call callback with the result. The job is
+   released by the pool. Returns false if the job couldn't be allocated. */
+bool DLL_EXPORT crc_pool_submit_callback(crc_pool_t *pool, params_t *params, uint64_t crc, unsigned char const *buf, uint64_t len, crc_callback_t callback, void *arg);
+
+/* Block until the job is done and return its CRC. */
+uint64_t DLL_EXPORT crc_job_wait(crc_job_t *job);
+
+/* Check if the job is done without blocking. */
+bool DLL_EXPORT crc_job_done(crc_job_t *job);
+
+/* Release a job returned by crc_pool_submit. The job must be done. */
+void DLL_EXPORT crc_job_free(crc_job_t *job);
+
+#endif
@@ -0,0 +1,163 @@
+#include <stdlib.h>
+#include "registry.h"
+#include "thread.h"
+
+/* Initial number of slots in the hash table. Must be a power of 2. */
+#define REGISTRY_SIZE 64
+
+//----------------------------------------
+
+/* Registry structures */
+
+/* The parameters that identify an entry, as passed to crc_params. */
+typedef struct {
+    uint8_t width;
+    uint64_t poly;
+    uint64_t init;
+    bool refin;
+    bool refout;
+    uint64_t xorout;
+} model_key_t;
+
+typedef struct {
+    model_key_t key;
+    uint64_t check;
+    params_t params;
+} entry_t;
+
+/* Open addressing hash table of entries. Entries are never removed or moved,
+   so the pointers that were handed out remain valid. */
+static entry_t **registry_slots = NULL;
+static uint64_t registry_size = 0;
+static uint64_t registry_count = 0;
+static mutex_t registry_lock = MUTEX_INITIALIZER;
+
+//----------------------------------------
+
+/* Hash table functions */
+
+/* Mixes the bits of x (splitmix64 finalizer). */
+static uint64_t mix(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+static uint64_t key_hash(model_key_t *key) {
+    uint64_t h = mix(key->poly ^ ((uint64_t)key->width << 1 | key->refin) ^ ((uint64_t)key->refout << 9));
+    h = mix(h ^ key->init);
+    return mix(h ^ key->xorout);
+}
+
+static bool key_equal(model_key_t *a, model_key_t *b) {
+    return a->width == b->width && a->poly == b->poly && a->init == b->init &&
+           a->refin == b->refin && a->refout == b->refout && a->xorout == b->xorout;
+}
+
+/* Find the slot holding key, or the empty slot where it should be inserted. */
+static entry_t **registry_find(model_key_t *key) {
+    uint64_t i = key_hash(key) & (registry_size - 1);
+
+    while(registry_slots[i] && !key_equal(&registry_slots[i]->key, key)) {
+        i = (i + 1) & (registry_size - 1);
+    }
+
+    return &registry_slots[i];
+}
+
+/* Double the size of the table. Returns false if it couldn't be allocated. */
+static bool registry_grow() {
+    uint64_t size = registry_size ? registry_size * 2 : REGISTRY_SIZE;
+    entry_t **slots = (entry_t**) calloc(size, sizeof(entry_t*));
+
+    if(slots == NULL) {
+        return false;
+    }
+
+    entry_t **old_slots = registry_slots;
+    uint64_t old_size = registry_size;
+
+    registry_slots = slots;
+    registry_size = size;
+
+    for(uint64_t i = 0; i < old_size; i++) {
+        if(old_slots[i]) {
+            *registry_find(&old_slots[i]->key) = old_slots[i];
+        }
+    }
+
+    free(old_slots);
+    return true;
+}
+
+//----------------------------------------
+
+/* Registry interface */
+
+params_t *crc_params_get(uint8_t width, uint64_t poly, uint64_t init, bool refin, bool refout, uint64_t xorout, uint64_t check, uint8_t *error) {
+    model_key_t key = {width, poly, init, refin, refout, xorout};
+    params_t *params = NULL;
+    *error = 0;
+
+    mutex_lock(&registry_lock);
+
+    //Keep the load factor below 1/2.
+    if(2 * (registry_count + 1) > registry_size && !registry_grow()) {
+        mutex_unlock(&registry_lock);
+        return NULL;
+    }
+
+    entry_t **slot = registry_find(&key);
+
+    if(*slot) {
+        if((*slot)->check == check) {
+            params = &(*slot)->params;
+        } else {
+            *error = CRC_CHECK_INVALID;
+        }
+
+        mutex_unlock(&registry_lock);
+        return params;
+    }
+
+    mutex_unlock(&registry_lock);
+
+    //Construct the parameters outside of the lock.
+    entry_t *entry = (entry_t*) malloc(sizeof(entry_t));
+
+    if(entry == NULL) {
+        return NULL;
+    }
+
+    entry->key = key;
+    entry->check = check;
+    entry->params = crc_params(width, poly, init, refin, refout, xorout, check, error);
+
+    if(*error) {
+        free(entry);
+        return NULL;
+    }
+
+    mutex_lock(&registry_lock);
+
+    //Another thread may have inserted the same parameters in the meantime.
+    if(2 * (registry_count + 1) > registry_size && !registry_grow()) {
+        mutex_unlock(&registry_lock);
+        free(entry);
+        return NULL;
+    }
+
+    slot = registry_find(&key);
+
+    if(*slot) {
+        free(entry);
+    } else {
+        *slot = entry;
+        registry_count++;
+    }
+
+    params = &(*slot)->params;
+    mutex_unlock(&registry_lock);
+
+    return params;
+}
@@ -0,0 +1,14 @@
+#ifndef CRC_REGISTRY_H
+#define CRC_REGISTRY_H
+
+#include "crc.h"
+
+/* Return a params_t struct shared by the whole process for the provided
+   parameters. It's constructed by crc_params the first time a set of parameters
+   is requested, and later requests with the same parameters only cost a hash
+   lookup. Safe to call from multiple threads. The returned struct must not be
+   modified or freed. Returns NULL if the parameters are invalid, in which case
+   error is set like in crc_params. */
+params_t DLL_EXPORT *crc_params_get(uint8_t width, uint64_t poly, uint64_t init, bool refin, bool refout, uint64_t xorout, uint64_t check, uint8_t *error);
+
+#endif
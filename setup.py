@@ -0,0 +1,9 @@
+# Builds the crc_clmul extension module
+# python setup.py build_ext --inplace
+
+from setuptools import setup, Extension
+
+setup(
+    name='crc_clmul',
+    ext_modules=[Extension('crc_clmul', sources=['crc_module.c', 'crc.c', 'cpu.c'])]
+)
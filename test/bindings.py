@@ -11,6 +11,12 @@ else:
 
 _crc = ctypes.CDLL(os.path.join(os.path.dirname(__file__), 'crc' + ext))
 
+# Note: Update this definition when the equivalent C code is changed
+class compact_table_t(ctypes.Union):
+    _fields_ = [('u8', ctypes.c_uint8 * 256),
+               ('u16', ctypes.c_uint16 * 256),
+               ('u32', ctypes.c_uint32 * 256)]
+
 # Note: Update this definition when the equivalent C code is changed
 class params_t(ctypes.Structure):
     _fields_ = [('width', ctypes.c_uint8),
@@ -23,15 +29,80 @@ class params_t(ctypes.Structure):
                ('k2', ctypes.c_uint64),
                ('k3', ctypes.c_uint64),
                ('k4', ctypes.c_uint64),
+               ('k5', ctypes.c_uint64),
+               ('k6', ctypes.c_uint64),
+               ('k7', ctypes.c_uint64),
+               ('k8', ctypes.c_uint64),
                ('u', ctypes.c_uint64),
                ('table', ctypes.c_uint64 * 256),
-               ('combine_table', ctypes.c_uint64 * 64)]
+               ('compact_table', compact_table_t),
+               ('combine_table', ctypes.c_uint64 * 64),
+               ('uncombine_table', ctypes.c_uint64 * 64)]
+
+# Note: Update this definition when the equivalent C code is changed
+class crc_tuning_t(ctypes.Structure):
+    _fields_ = [('clmul_min', ctypes.c_uint64),
+               ('align_min', ctypes.c_uint64),
+               ('fold4_min', ctypes.c_uint64),
+               ('shuffle_min', ctypes.c_uint64)]
+
+class range_t(ctypes.Structure):
+    _fields_ = [('offset', ctypes.c_uint64),
+               ('len', ctypes.c_uint64)]
+
+# Note: Update this definition when the equivalent C code is changed
+class crc_assembler_t(ctypes.Structure):
+    _fields_ = [('params', ctypes.POINTER(params_t)),
+               ('len', ctypes.c_uint64),
+               ('crc', ctypes.c_uint64),
+               ('covered', ctypes.c_uint64)]
+
+# Note: Update this definition when the equivalent C code is changed
+class crc_model_t(ctypes.Structure):
+    _fields_ = [('name', ctypes.c_char_p),
+               ('width', ctypes.c_uint8),
+               ('poly', ctypes.c_uint64),
+               ('init', ctypes.c_uint64),
+               ('refin', ctypes.c_bool),
+               ('refout', ctypes.c_bool),
+               ('xorout', ctypes.c_uint64),
+               ('check', ctypes.c_uint64)]
+
+class crc_sample_t(ctypes.Structure):
+    _fields_ = [('buf', ctypes.c_char_p),
+               ('len', ctypes.c_uint64),
+               ('crc', ctypes.c_uint64)]
+
+class crc_candidate_t(ctypes.Structure):
+    _fields_ = [('model', crc_model_t),
+               ('exact', ctypes.c_bool),
+               ('free_bits', ctypes.c_uint8)]
+
+class crc128_t(ctypes.Structure):
+    _fields_ = [('hi', ctypes.c_uint64),
+               ('lo', ctypes.c_uint64)]
+
+# Note: Update this definition when the equivalent C code is changed
+class params128_t(ctypes.Structure):
+    _fields_ = [('width', ctypes.c_uint8),
+               ('poly', crc128_t),
+               ('refin', ctypes.c_bool),
+               ('refout', ctypes.c_bool),
+               ('init', crc128_t),
+               ('xorout', crc128_t),
+               ('k', crc128_t * 16),
+               ('u', ctypes.c_uint64),
+               ('table', crc128_t * 256),
+               ('combine_table', crc128_t * 64)]
 
 _crc.cpu_check_features.argtypes = []
 
 _crc.crc_params.argtypes = [ctypes.c_uint8, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_bool, ctypes.c_bool, ctypes.c_uint64, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint8)]
 _crc.crc_params.restype = params_t
 
+_crc.crc_params_get.argtypes = [ctypes.c_uint8, ctypes.c_uint64, ctypes.c_uint64, ctypes.c_bool, ctypes.c_bool, ctypes.c_uint64, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint8)]
+_crc.crc_params_get.restype = ctypes.POINTER(params_t)
+
 _crc.crc_print_errors.argtypes = [ctypes.c_uint8]
 
 _crc.crc_table.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
@@ -40,6 +111,15 @@ _crc.crc_table.restype = ctypes.c_uint64
 _crc.crc_calc.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
 _crc.crc_calc.restype = ctypes.c_uint64
 
+_crc.crc_calc_tuned.argtypes = [ctypes.POINTER(params_t), ctypes.POINTER(crc_tuning_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc_calc_tuned.restype = ctypes.c_uint64
+
+_crc.crc_calc_padded.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc_calc_padded.restype = ctypes.c_uint64
+
+_crc.crc_calc_strided.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64, ctypes.c_int64, ctypes.c_uint64]
+_crc.crc_calc_strided.restype = ctypes.c_uint64
+
 _crc.crc_zeros.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_uint64]
 _crc.crc_zeros.restype = ctypes.c_uint64
 
@@ -49,8 +129,125 @@ _crc.crc_combine_constant.restype = ctypes.c_uint64
 _crc.crc_combine.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64]
 _crc.crc_combine.restype = ctypes.c_uint64
 
+_crc.crc_combine_many.argtypes = [ctypes.POINTER(params_t), ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_uint64), ctypes.c_uint64]
+_crc.crc_combine_many.restype = ctypes.c_uint64
+
+_crc.crc_uncombine_constant.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64]
+_crc.crc_uncombine_constant.restype = ctypes.c_uint64
+
+_crc.crc_remove_prefix.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_remove_prefix.restype = ctypes.c_uint64
+
+_crc.crc_remove_suffix.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_remove_suffix.restype = ctypes.c_uint64
+
+_crc.crc_calc_blocks.argtypes = [ctypes.POINTER(params_t), ctypes.c_char_p, ctypes.c_uint64, ctypes.c_uint64, ctypes.POINTER(ctypes.c_uint64), ctypes.POINTER(ctypes.c_uint64)]
+_crc.crc_calc_blocks.restype = ctypes.c_bool
+
+_crc.crc_calc_sparse.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64, ctypes.POINTER(range_t), ctypes.c_uint64]
+_crc.crc_calc_sparse.restype = ctypes.c_uint64
+
+_crc.crc_assembler_init.argtypes = [ctypes.POINTER(crc_assembler_t), ctypes.POINTER(params_t), ctypes.c_uint64]
+
+_crc.crc_assembler_add.argtypes = [ctypes.POINTER(crc_assembler_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc_assembler_add.restype = ctypes.c_bool
+
+_crc.crc_assembler_add_crc.argtypes = [ctypes.POINTER(crc_assembler_t), ctypes.c_uint64, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_assembler_add_crc.restype = ctypes.c_bool
+
+_crc.crc_assembler_done.argtypes = [ctypes.POINTER(crc_assembler_t)]
+_crc.crc_assembler_done.restype = ctypes.c_bool
+
+_crc.crc_assembler_result.argtypes = [ctypes.POINTER(crc_assembler_t)]
+_crc.crc_assembler_result.restype = ctypes.c_uint64
+
+_crc.crc128_params.argtypes = [ctypes.c_uint8, crc128_t, crc128_t, ctypes.c_bool, ctypes.c_bool, crc128_t, crc128_t, ctypes.POINTER(ctypes.c_uint8)]
+_crc.crc128_params.restype = params128_t
+
+_crc.crc128_table.argtypes = [ctypes.POINTER(params128_t), crc128_t, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc128_table.restype = crc128_t
+
+_crc.crc128_calc.argtypes = [ctypes.POINTER(params128_t), crc128_t, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc128_calc.restype = crc128_t
+
+_crc.crc128_combine_constant.argtypes = [ctypes.POINTER(params128_t), ctypes.c_uint64]
+_crc.crc128_combine_constant.restype = crc128_t
+
+_crc.crc128_combine.argtypes = [ctypes.POINTER(params128_t), crc128_t, crc128_t, crc128_t]
+_crc.crc128_combine.restype = crc128_t
+
+_crc.crc_calc_masked.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64, ctypes.POINTER(range_t), ctypes.c_uint64]
+_crc.crc_calc_masked.restype = ctypes.c_uint64
+
+_crc.crc_autotune.argtypes = []
+
+_crc.crc_tuning_save.argtypes = [ctypes.c_char_p]
+_crc.crc_tuning_save.restype = ctypes.c_bool
+
+_crc.crc_tuning_load.argtypes = [ctypes.c_char_p]
+_crc.crc_tuning_load.restype = ctypes.c_bool
+
+crc_callback_t = ctypes.CFUNCTYPE(None, ctypes.c_uint64, ctypes.c_void_p)
+
+_crc.crc_index_build.argtypes = [ctypes.POINTER(params_t), ctypes.c_char_p, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_index_build.restype = ctypes.c_void_p
+
+_crc.crc_index_free.argtypes = [ctypes.c_void_p]
+
+_crc.crc_range.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_range.restype = ctypes.c_uint64
+
+_crc.crc_index_save.argtypes = [ctypes.c_void_p, ctypes.c_char_p]
+_crc.crc_index_save.restype = ctypes.c_bool
+
+_crc.crc_index_load.argtypes = [ctypes.POINTER(params_t), ctypes.c_char_p]
+_crc.crc_index_load.restype = ctypes.c_void_p
+
+_crc.crc_params_save.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p]
+_crc.crc_params_save.restype = ctypes.c_bool
+
+_crc.crc_params_map.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_uint64)]
+_crc.crc_params_map.restype = ctypes.POINTER(params_t)
+
+_crc.crc_params_unmap.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64]
+
+_crc.crc_syndromes_build.argtypes = [ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_bool]
+_crc.crc_syndromes_build.restype = ctypes.c_void_p
+
+_crc.crc_syndromes_free.argtypes = [ctypes.c_void_p]
+
+_crc.crc_correct.argtypes = [ctypes.POINTER(params_t), ctypes.c_void_p, ctypes.c_char_p, ctypes.c_uint64, ctypes.c_uint64]
+_crc.crc_correct.restype = ctypes.c_int
+
+_crc.crc_identify.argtypes = [ctypes.POINTER(crc_sample_t), ctypes.c_uint64, ctypes.POINTER(crc_candidate_t), ctypes.c_uint64]
+_crc.crc_identify.restype = ctypes.c_uint64
+
+_crc.crc_pool_create.argtypes = [ctypes.c_uint32, ctypes.c_uint64]
+_crc.crc_pool_create.restype = ctypes.c_void_p
+
+_crc.crc_pool_destroy.argtypes = [ctypes.c_void_p]
+
+_crc.crc_pool_submit.argtypes = [ctypes.c_void_p, ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64]
+_crc.crc_pool_submit.restype = ctypes.c_void_p
+
+_crc.crc_pool_submit_callback.argtypes = [ctypes.c_void_p, ctypes.POINTER(params_t), ctypes.c_uint64, ctypes.c_char_p, ctypes.c_uint64, crc_callback_t, ctypes.c_void_p]
+_crc.crc_pool_submit_callback.restype = ctypes.c_bool
+
+_crc.crc_job_wait.argtypes = [ctypes.c_void_p]
+_crc.crc_job_wait.restype = ctypes.c_uint64
+
+_crc.crc_job_done.argtypes = [ctypes.c_void_p]
+_crc.crc_job_done.restype = ctypes.c_bool
+
+_crc.crc_job_free.argtypes = [ctypes.c_void_p]
+
 cpu_check_features = _crc.cpu_check_features
 cpu_enable_simd = ctypes.c_bool.in_dll(_crc, 'cpu_enable_simd')
+cpu_enable_shuffle = ctypes.c_bool.in_dll(_crc, 'cpu_enable_shuffle')
+crc_tuning = crc_tuning_t.in_dll(_crc, 'crc_tuning')
+crc_catalogue_size = ctypes.c_uint64.in_dll(_crc, 'crc_catalogue_size').value
+crc_catalogue = (crc_model_t * crc_catalogue_size).in_dll(_crc, 'crc_catalogue')
+crc_autotune = _crc.crc_autotune
 
 def crc_params(width, poly, init, refin, refout, xorout, check):
     error = ctypes.c_uint8(0)
@@ -62,6 +259,16 @@ def crc_params(width, poly, init, refin, refout, xorout, check):
 
     return params
 
+def crc_params_get(width, poly, init, refin, refout, xorout, check):
+    error = ctypes.c_uint8(0)
+    params = _crc.crc_params_get(width, poly, init, refin, refout, xorout, check, ctypes.byref(error))
+
+    if error.value > 0:
+        _crc.crc_print_errors(error)
+        raise ValueError('Invalid CRC parameters.')
+
+    return params.contents
+
 def crc_table(params, crc, buf):
     return _crc.crc_table(ctypes.byref(params), crc, buf, len(buf))
 
@@ -75,6 +282,25 @@ def crc_calc_unaligned(params, crc, buf, shift):
 
     return _crc.crc_calc(ctypes.byref(params), crc, pointer2, len(buf) - shift)
 
+def crc_calc_tuned(params, tuning, crc, buf):
+    return _crc.crc_calc_tuned(ctypes.byref(params), ctypes.byref(tuning), crc, buf, len(buf))
+
+# Computes the CRC of buf[pad:], so buf must start with at least 16 bytes of padding
+def crc_calc_padded(params, crc, buf, pad):
+    pointer = ctypes.cast(buf, ctypes.POINTER(ctypes.c_char))
+    address = ctypes.addressof(pointer.contents)
+    pointer2 = ctypes.cast(address + pad, ctypes.POINTER(ctypes.c_char))
+
+    return _crc.crc_calc_padded(ctypes.byref(params), crc, pointer2, len(buf) - pad)
+
+# Computes the CRC of count elements of buf, the first of which starts at offset
+def crc_calc_strided(params, crc, buf, offset, elem_len, stride, count):
+    pointer = ctypes.cast(buf, ctypes.POINTER(ctypes.c_char))
+    address = ctypes.addressof(pointer.contents)
+    pointer2 = ctypes.cast(address + offset, ctypes.POINTER(ctypes.c_char))
+
+    return _crc.crc_calc_strided(ctypes.byref(params), crc, pointer2, elem_len, stride, count)
+
 def crc_zeros(params, crc, n):
     return _crc.crc_zeros(ctypes.byref(params), crc, n)
 
@@ -82,4 +308,156 @@ def crc_combine_constant(params, len):
     return _crc.crc_combine_constant(ctypes.byref(params), len)
 
 def crc_combine(params, crc, crc2, xp):
-    return _crc.crc_combine(ctypes.byref(params), crc, crc2, xp)
\ No newline at end of file
+    return _crc.crc_combine(ctypes.byref(params), crc, crc2, xp)
+
+def crc_combine_many(params, crcs, lens):
+    crcs = (ctypes.c_uint64 * len(crcs))(*crcs)
+    lens = (ctypes.c_uint64 * len(lens))(*lens)
+    return _crc.crc_combine_many(ctypes.byref(params), crcs, lens, len(crcs))
+
+def crc_uncombine_constant(params, len):
+    return _crc.crc_uncombine_constant(ctypes.byref(params), len)
+
+def crc_remove_prefix(params, crc, crc_prefix, xp):
+    return _crc.crc_remove_prefix(ctypes.byref(params), crc, crc_prefix, xp)
+
+def crc_remove_suffix(params, crc, crc_suffix, xp):
+    return _crc.crc_remove_suffix(ctypes.byref(params), crc, crc_suffix, xp)
+
+# Returns the list of block CRCs and the CRC of the whole buffer
+def crc_calc_blocks(params, buf, block_size):
+    block_crcs = (ctypes.c_uint64 * max((len(buf) + block_size - 1) // block_size, 1))()
+    total_crc = ctypes.c_uint64()
+    _crc.crc_calc_blocks(ctypes.byref(params), buf, len(buf), block_size, block_crcs, ctypes.byref(total_crc))
+    return list(block_crcs)[:(len(buf) + block_size - 1) // block_size], total_crc.value
+
+def crc_calc_sparse(params, crc, buf, holes):
+    ranges = (range_t * len(holes))(*holes)
+    return _crc.crc_calc_sparse(ctypes.byref(params), crc, buf, len(buf), ranges, len(holes))
+
+# The params must stay alive while the assembler is used
+def crc_assembler_init(params, len):
+    assembler = crc_assembler_t()
+    _crc.crc_assembler_init(ctypes.byref(assembler), ctypes.byref(params), len)
+    return assembler
+
+def crc_assembler_add(assembler, offset, buf):
+    return _crc.crc_assembler_add(ctypes.byref(assembler), offset, buf, len(buf))
+
+def crc_assembler_add_crc(assembler, offset, crc, len):
+    return _crc.crc_assembler_add_crc(ctypes.byref(assembler), offset, crc, len)
+
+def crc_assembler_done(assembler):
+    return _crc.crc_assembler_done(ctypes.byref(assembler))
+
+def crc_assembler_result(assembler):
+    return _crc.crc_assembler_result(ctypes.byref(assembler))
+
+# CRCs wider than 64 bits are passed to and from these functions as Python ints
+def _to128(value):
+    return crc128_t(value >> 64, value & 0xffffffffffffffff)
+
+def _from128(value):
+    return (value.hi << 64) | value.lo
+
+def crc128_params(width, poly, init, refin, refout, xorout, check):
+    error = ctypes.c_uint8(0)
+    params = _crc.crc128_params(width, _to128(poly), _to128(init), refin, refout, _to128(xorout), _to128(check), ctypes.byref(error))
+
+    if error.value > 0:
+        _crc.crc_print_errors(error)
+        raise ValueError('Invalid CRC parameters.')
+
+    return params
+
+def crc128_init(params):
+    return _from128(params.init)
+
+def crc128_table(params, crc, buf):
+    return _from128(_crc.crc128_table(ctypes.byref(params), _to128(crc), buf, len(buf)))
+
+def crc128_calc(params, crc, buf):
+    return _from128(_crc.crc128_calc(ctypes.byref(params), _to128(crc), buf, len(buf)))
+
+def crc128_combine_constant(params, len):
+    return _from128(_crc.crc128_combine_constant(ctypes.byref(params), len))
+
+def crc128_combine(params, crc, crc2, xp):
+    return _from128(_crc.crc128_combine(ctypes.byref(params), _to128(crc), _to128(crc2), _to128(xp)))
+
+def crc_calc_masked(params, crc, buf, zero_ranges):
+    ranges = (range_t * len(zero_ranges))(*zero_ranges)
+    return _crc.crc_calc_masked(ctypes.byref(params), crc, buf, len(buf), ranges, len(zero_ranges))
+
+def crc_tuning_save(path):
+    return _crc.crc_tuning_save(os.fsencode(path))
+
+def crc_tuning_load(path):
+    return _crc.crc_tuning_load(os.fsencode(path))
+
+def crc_pool_create(threads, split):
+    return _crc.crc_pool_create(threads, split)
+
+def crc_pool_destroy(pool):
+    _crc.crc_pool_destroy(pool)
+
+def crc_pool_submit(pool, params, crc, buf):
+    return _crc.crc_pool_submit(pool, ctypes.byref(params), crc, buf, len(buf))
+
+def crc_pool_submit_callback(pool, params, crc, buf, callback):
+    return _crc.crc_pool_submit_callback(pool, ctypes.byref(params), crc, buf, len(buf), callback, None)
+
+def crc_job_wait(job):
+    return _crc.crc_job_wait(job)
+
+def crc_job_done(job):
+    return _crc.crc_job_done(job)
+
+def crc_job_free(job):
+    _crc.crc_job_free(job)
+
+def crc_index_build(params, buf, block):
+    return _crc.crc_index_build(ctypes.byref(params), buf, len(buf), block)
+
+def crc_index_free(index):
+    _crc.crc_index_free(index)
+
+def crc_range(index, buf, offset, len):
+    return _crc.crc_range(index, buf, offset, len)
+
+def crc_index_save(index, path):
+    return _crc.crc_index_save(index, os.fsencode(path))
+
+def crc_index_load(params, path):
+    return _crc.crc_index_load(ctypes.byref(params), os.fsencode(path))
+
+def crc_params_save(params, path):
+    array = (params_t * len(params))(*params)
+    return _crc.crc_params_save(array, len(params), os.fsencode(path))
+
+# Returns the mapped array and the number of structs in it, or None on failure
+def crc_params_map(path):
+    count = ctypes.c_uint64()
+    params = _crc.crc_params_map(os.fsencode(path), ctypes.byref(count))
+    return (params, count.value) if params else None
+
+def crc_params_unmap(params, count):
+    _crc.crc_params_unmap(params, count)
+
+def crc_syndromes_build(params, max_len, double_bits):
+    return _crc.crc_syndromes_build(ctypes.byref(params), max_len, double_bits)
+
+def crc_syndromes_free(syndromes):
+    _crc.crc_syndromes_free(syndromes)
+
+# buf must be a bytearray, which is corrected in place
+def crc_correct(params, syndromes, buf, expected):
+    array = (ctypes.c_char * len(buf)).from_buffer(buf)
+    return _crc.crc_correct(ctypes.byref(params), syndromes, array, len(buf), expected)
+
+# samples is a list of (message, crc) pairs. Returns the list of candidates.
+def crc_identify(samples, max=64):
+    array = (crc_sample_t * len(samples))(*[(buf, len(buf), crc) for buf, crc in samples])
+    candidates = (crc_candidate_t * max)()
+    count = _crc.crc_identify(array, len(samples), candidates, max)
+    return candidates[:min(count, max)]
\ No newline at end of file
@@ -1,6 +1,18 @@
 from bindings import *
-from models import models
+from models import models, wide_models
+import ctypes
+import os
 import sys
+import tempfile
+import threading
+
+# The extension module is optional. It's built in the repository root by setup.py.
+sys.path.append(os.path.join(os.path.dirname(__file__), '..'))
+
+try:
+    import crc_clmul
+except ImportError:
+    crc_clmul = None
 
 # Test CPU features
 use_simd = True
@@ -18,10 +30,116 @@ if not use_simd and cpu_enable_simd:
 
 #----------------------------------------
 
+# Test the autotuner
+crc_autotune()
+print(f'Tuning: clmul_min={crc_tuning.clmul_min} align_min={crc_tuning.align_min} fold4_min={crc_tuning.fold4_min} shuffle_min={crc_tuning.shuffle_min}')
+
+if crc_tuning.clmul_min < 16 or crc_tuning.fold4_min < 48:
+    raise Exception('Invalid tuning')
+
+# Restore the tuning from a file after resetting it to the defaults
+tuned = (crc_tuning.clmul_min, crc_tuning.align_min, crc_tuning.fold4_min, crc_tuning.shuffle_min)
+tuning_path = os.path.join(tempfile.mkdtemp(), 'tuning.txt')
+
+if not crc_tuning_save(tuning_path):
+    raise Exception('Failed to save the tuning')
+
+crc_tuning.clmul_min, crc_tuning.align_min, crc_tuning.fold4_min, crc_tuning.shuffle_min = 16, 512, 48, 1024
+
+if not crc_tuning_load(tuning_path) or (crc_tuning.clmul_min, crc_tuning.align_min, crc_tuning.fold4_min, crc_tuning.shuffle_min) != tuned:
+    raise Exception('Failed to load the tuning')
+
+os.remove(tuning_path)
+os.rmdir(os.path.dirname(tuning_path))
+
+# Test mapping an image of all the models
+image_path = os.path.join(tempfile.mkdtemp(), 'params.bin')
+
+if not crc_params_save([crc_params(*model) for model in models.values()], image_path):
+    raise Exception('Failed to save the params image')
+
+image = crc_params_map(image_path)
+
+if image is None or image[1] != len(models):
+    raise Exception('Failed to map the params image')
+
+# An image with a modified byte fails the checksum
+# Modify a copy, since the mapped image shares the pages of the file
+corrupted_path = image_path + '.corrupted'
+
+with open(image_path, 'rb') as file:
+    data = bytearray(file.read())
+
+data[100] ^= 1
+
+with open(corrupted_path, 'wb') as file:
+    file.write(data)
+
+if crc_params_map(corrupted_path) is not None:
+    raise Exception('Mapped a corrupted params image')
+
+os.remove(corrupted_path)
+
+# Saving the same models again writes the same bytes, padding included
+again_path = image_path + '.again'
+
+if not crc_params_save([crc_params(*model) for model in models.values()], again_path):
+    raise Exception('Failed to save the params image')
+
+with open(image_path, 'rb') as file, open(again_path, 'rb') as file2:
+    if file.read() != file2.read():
+        raise Exception('The params images of the same models differ')
+
+os.remove(again_path)
+
+# Test that the C catalogue matches the models
+catalogue = {m.name.decode(): (m.width, m.poly, m.init, m.refin, m.refout, m.xorout, m.check) for m in crc_catalogue}
+
+if catalogue != {name: tuple(model) for name, model in models.items()}:
+    raise Exception('The catalogue differs from the models')
+
+# Identify a catalogue model from samples of different lengths
+messages = [b'123456789', bytes(range(200)), bytes(1000), b'\x01' * 33]
+crc32 = crc_params(*models['CRC32-ISO-HDLC'])
+candidates = crc_identify([(m, crc_table(crc32, crc32.init, m)) for m in messages])
+
+if len(candidates) != 1 or candidates[0].model.name != b'CRC32-ISO-HDLC' or not candidates[0].exact:
+    raise Exception('Failed to identify a catalogue model')
+
+# Identify a model with a made up init and xorout. Starting from another CRC
+# value and XORing the result changes both.
+candidates = crc_identify([(m, crc_table(crc32, 0x12345678, m) ^ 0x9abcdef0) for m in messages])
+
+if len(candidates) != 1 or candidates[0].exact or candidates[0].free_bits != 0:
+    raise Exception('Failed to identify a model with a different init and xorout')
+
+m = candidates[0].model
+solved = crc_params(m.width, m.poly, m.init, m.refin, m.refout, m.xorout, m.check)
+message = bytes(range(77))
+
+if crc_table(solved, solved.init, message) != crc_table(crc32, 0x12345678, message) ^ 0x9abcdef0:
+    raise Exception('The solved init and xorout are wrong')
+
+# CRCs that no model produces
+if crc_identify([(m, 0xf000000000000000 + len(m)) for m in messages]):
+    raise Exception('Identified a model from unrelated CRCs')
+
+# Test the default code paths
+crc_tuning.clmul_min, crc_tuning.align_min, crc_tuning.fold4_min, crc_tuning.shuffle_min = 16, 512, 48, 1024
+
+#----------------------------------------
+
 # Test CRC
 test_data = bytes(b & 0xff for b in range(300))
+long_data = test_data * 4
+shuffle_data = long_data * 2
+sparse_data = bytes(9000) + test_data + bytes(5000)
 failed = False
 
+# Split jobs longer than 64 bytes to test joining the sub-ranges
+pool = crc_pool_create(4, 64)
+index_path = os.path.join(tempfile.mkdtemp(), 'index.bin')
+
 def check(test_name, test_value, actual_value, print_result_if_true=True):
     result = test_value == actual_value
 
@@ -40,6 +158,19 @@ for name, model in models.items():
     value = crc_table(params, params.init, b'123456789')
     check('Table', value, model.check)
 
+    # Test the mapped params image
+    mapped = image[0][list(models).index(name)]
+    value = crc_calc(mapped, mapped.init, test_data)
+    value2 = crc_table(params, params.init, test_data)
+    check('Image', value, value2, False)
+
+    # Test the params registry
+    shared = crc_params_get(*model)
+    shared2 = crc_params_get(*model)
+    value = crc_calc(shared, shared.init, b'123456789')
+    check('Registry', value, model.check)
+    check('Registry Same', ctypes.addressof(shared), ctypes.addressof(shared2), False)
+
     # Test crc_calc when len < 16
     value = crc_calc(params, params.init, test_data[:10])
     value2 = crc_table(params, params.init, test_data[:10])
@@ -72,6 +203,63 @@ for name, model in models.items():
         value2 = crc_table(params, params.init, test_data[i:])
         check('Unaligned', value, value2, False)
 
+    # Test crc_calc with every length up to 300 and different alignments
+    for i in range(len(test_data)):
+        buf = test_data[:i]
+        value = crc_calc_unaligned(params, params.init, buf, i % 16)
+        value2 = crc_table(params, params.init, buf[i % 16:])
+        check('Lengths', value, value2, False)
+
+    # Test crc_calc_tuned with the table-based algorithm only, with every buffer
+    # aligned and folded by 4 as early as possible, and with the shuffle
+    # algorithm for every length if it's available
+    for tuning in (crc_tuning_t(2**64 - 1, 2**64 - 1, 2**64 - 1, 2**64 - 1), crc_tuning_t(16, 0, 48, 0),
+                   crc_tuning_t(2**64 - 1, 512, 48, 0)):
+        for n in (17, 64, 300, len(long_data)):
+            value = crc_calc_tuned(params, tuning, params.init, long_data[:n])
+            check('Tuned', value, crc_table(params, params.init, long_data[:n]), False)
+
+    # Test crc_calc_padded with every length up to 300. The padding holds
+    # non-zero bytes, which must not affect the CRC.
+    padded = b'\xff' * 16 + test_data
+    for i in range(len(test_data)):
+        value = crc_calc_padded(params, params.init, padded[:16 + i], 16)
+        value2 = crc_table(params, params.init, test_data[:i])
+        check('Padded', value, value2, False)
+
+    # Test crc_calc_strided with whole blocks per element, some of them folded
+    # by 4, elements of 16 and 32 bytes, elements that aren't whole blocks, too
+    # few blocks to fold, no elements, and a negative stride starting from the
+    # last element
+    for offset, elem_len, stride, count in ((0, 48, 64, 18), (0, 80, 96, 12), (0, 16, 24, 40), (8, 32, 80, 12),
+                                            (0, 100, 128, 8), (0, 16, 32, 3), (0, 64, 64, 0), (64 * 17, 48, -64, 18)):
+        value = crc_calc_strided(params, params.init, long_data, offset, elem_len, stride, count)
+        elems = b''.join(long_data[offset + i * stride:offset + i * stride + elem_len] for i in range(count))
+        check('Strided', value, crc_table(params, params.init, elems), False)
+
+    # Test crc_calc with a buffer long enough to be aligned
+    for i in range(0, 16):
+        value = crc_calc_unaligned(params, params.init, long_data, i)
+        value2 = crc_table(params, params.init, long_data[i:])
+        check('Long Unaligned', value, value2, False)
+
+    # Test that the functions for wider CRCs give the same results
+    params128 = crc128_params(*model)
+    for i in (0, 10, 100, 300, 1200):
+        value = crc128_calc(params128, crc128_init(params128), long_data[3:i])
+        value2 = crc_table(params, params.init, long_data[3:i])
+        check('Wide', value, value2, False)
+
+    # Test the shuffle algorithm by hiding CLMUL, with tails of different lengths
+    if cpu_enable_shuffle:
+        simd = cpu_enable_simd.value
+        cpu_enable_simd.value = False
+        for i in range(0, 300, 37):
+            value = crc_calc_unaligned(params, params.init, shuffle_data, i)
+            value2 = crc_table(params, params.init, shuffle_data[i:])
+            check('Shuffle', value, value2, False)
+        cpu_enable_simd.value = simd
+
     # Test crc_combine_constant
     for i in range(0, 16):
         j = 2 ** i
@@ -87,8 +275,244 @@ for name, model in models.items():
     value4 = crc_table(params, params.init, test_data)
     check('Combine', value3, value4)
 
+    # Test crc_combine_many with pieces of different lengths, and with more
+    # pieces of the same length than are reduced at a time
+    for cuts in ([], [0, 300], [0, 1, 17, 64, 65, 150, 299, 300], list(range(301))):
+        pieces = [test_data[a:b] for a, b in zip(cuts, cuts[1:])]
+        crcs = [crc_calc(params, params.init, piece) for piece in pieces]
+        value = crc_combine_many(params, crcs, [len(piece) for piece in pieces])
+        value2 = crc_table(params, params.init, b''.join(pieces))
+        check('Combine Many', value, value2, False)
+
+    # Test removing a prefix and a suffix, including empty ones
+    for i in (0, 1, 150, 300):
+        crc = crc_table(params, params.init, test_data)
+        crc_prefix = crc_table(params, params.init, test_data[:i])
+        crc_suffix = crc_table(params, params.init, test_data[i:])
+        xp = crc_combine_constant(params, len(test_data) - i)
+        value = crc_remove_prefix(params, crc, crc_prefix, xp)
+        check('Remove Prefix', value, crc_suffix, False)
+        xp = crc_uncombine_constant(params, len(test_data) - i)
+        value = crc_remove_suffix(params, crc, crc_suffix, xp)
+        check('Remove Suffix', value, crc_prefix, False)
+
+    # Test crc_calc_blocks with a partial last block, whole blocks only, one
+    # block longer than the buffer, and an empty buffer
+    for buf, block_size in ((long_data, 64), (long_data, 400), (test_data, 1000), (b'', 16)):
+        blocks, total = crc_calc_blocks(params, buf, block_size)
+        value = [crc_table(params, params.init, buf[i:i + block_size]) for i in range(0, len(buf), block_size)]
+        check('Blocks', blocks == value, True, False)
+        check('Blocks Total', total, crc_table(params, params.init, buf), False)
+
+    # Test crc_calc_sparse with runs of zero pages
+    value = crc_calc_sparse(params, params.init, sparse_data, [])
+    value2 = crc_table(params, params.init, sparse_data)
+    check('Sparse', value, value2)
+
+    # Test crc_calc_sparse with holes, including one that extends past the end
+    holes = [(0, 5), (20, 100), (150, 1), (290, 50)]
+    zeroed = bytearray(test_data)
+    for offset, n in holes:
+        zeroed[offset:offset + n] = bytes(len(zeroed[offset:offset + n]))
+    value = crc_calc_sparse(params, params.init, test_data, holes)
+    value2 = crc_table(params, params.init, bytes(zeroed))
+    check('Sparse Holes', value, value2)
+
+    # Test crc_calc_masked with a short field, a range folded from the zero block,
+    # and a range long enough to be skipped
+    for ranges in ([(4, 4)], [(0, 1), (10, 200), (300, 1000)], [(100, 1100)]):
+        zeroed = bytearray(long_data)
+        for offset, n in ranges:
+            zeroed[offset:offset + n] = bytes(len(zeroed[offset:offset + n]))
+        value = crc_calc_masked(params, params.init, long_data, ranges)
+        value2 = crc_table(params, params.init, bytes(zeroed))
+        check('Masked', value, value2, False)
+
+    # Test the assembler with pieces added in reverse order, by buffer and by CRC
+    cuts = [0, 1, 17, 64, 150, 299, 300]
+    assembler = crc_assembler_init(params, len(test_data))
+    for i, (a, b) in reversed(list(enumerate(zip(cuts, cuts[1:])))):
+        check('Assembler Done', crc_assembler_done(assembler), False, False)
+        if i % 2:
+            crc_assembler_add(assembler, a, test_data[a:b])
+        else:
+            crc_assembler_add_crc(assembler, a, crc_table(params, params.init, test_data[a:b]), b - a)
+    check('Assembler Done', crc_assembler_done(assembler), True, False)
+    value = crc_assembler_result(assembler)
+    value2 = crc_table(params, params.init, test_data)
+    check('Assembler', value, value2)
+    check('Assembler Bounds', crc_assembler_add_crc(assembler, 299, 0, 2), False, False)
+
+    # Test the assembler with pieces added from several threads at once
+    assembler = crc_assembler_init(params, len(long_data))
+
+    def add_pieces(start):
+        for i in range(start, len(long_data), 40):
+            crc_assembler_add(assembler, i, long_data[i:i + 10])
+
+    threads = [threading.Thread(target=add_pieces, args=(i * 10,)) for i in range(4)]
+    for thread in threads:
+        thread.start()
+    for thread in threads:
+        thread.join()
+    value = crc_assembler_result(assembler) if crc_assembler_done(assembler) else None
+    value2 = crc_table(params, params.init, long_data)
+    check('Assembler Threads', value, value2, False)
+
+    # Test the range index with ranges that start and end inside and on block boundaries
+    index = crc_index_build(params, long_data, 64)
+    for offset in (0, 1, 64, 100, 640):
+        for n in (0, 10, 64, 200, len(long_data) - offset):
+            value = crc_range(index, long_data, offset, n)
+            value2 = crc_table(params, params.init, long_data[offset:offset + n])
+            check('Range', value, value2, False)
+
+    # Test saving and loading the range index
+    crc_index_save(index, index_path)
+    crc_index_free(index)
+    index = crc_index_load(params, index_path)
+    value = crc_range(index, None, 128, len(long_data) - 128)
+    value2 = crc_table(params, params.init, long_data[128:])
+    check('Range Load', value, value2)
+    crc_index_free(index)
+
+    # Test crc_correct with one and two flipped bits. CRCs shorter than 32 bits
+    # can't detect or locate every error, in which case the buffer must be left
+    # unchanged. Wider CRCs must correct them all.
+    syndromes = crc_syndromes_build(params, len(test_data), True)
+    expected = crc_table(params, params.init, test_data)
+    for bits in ([0], [7], [1234], [2399], [5, 1000], [8, 2391]):
+        corrupted = bytearray(test_data)
+        for bit in bits:
+            corrupted[len(corrupted) - 1 - bit // 8] ^= 1 << (bit % 8)
+        received = bytes(corrupted)
+        value = crc_correct(params, syndromes, corrupted, expected)
+        if value <= 0 and model.width < 32:
+            check('Correct', bytes(corrupted) == received, True, False)
+        else:
+            check('Correct', value, len(bits), False)
+            check('Correct', bytes(corrupted) == test_data, True, False)
+    value = crc_correct(params, syndromes, bytearray(test_data), expected)
+    check('Correct None', value, 0, False)
+    crc_syndromes_free(syndromes)
+    check('Correct Limit', crc_syndromes_build(params, 2**60, False) is None, True, False)
+
+    # Test the thread pool
+    # The buffers must stay alive until the jobs are done
+    buffers = [test_data[:i] for i in (0, 10, 64, 100, 300)]
+    jobs = [crc_pool_submit(pool, params, params.init, buf) for buf in buffers]
+    for buf, job in zip(buffers, jobs):
+        value = crc_job_wait(job)
+        value2 = crc_table(params, params.init, buf)
+        check('Pool', value, value2, False)
+        crc_job_free(job)
+
+    # Test the thread pool with a callback
+    results = []
+    finished = threading.Event()
+
+    @crc_callback_t
+    def callback(crc, arg):
+        results.append(crc)
+        finished.set()
+
+    crc_pool_submit_callback(pool, params, params.init, test_data, callback)
+    finished.wait()
+    value = crc_table(params, params.init, test_data)
+    check('Pool Callback', results[0], value)
+
+    # Test the extension module with different buffer types
+    if crc_clmul:
+        module_params = crc_clmul.Params(*model)
+        value = crc_table(params, params.init, test_data[3:])
+        for buf in (test_data[3:], bytearray(test_data[3:]), memoryview(test_data)[3:]):
+            value2 = crc_clmul.crc_calc(module_params, module_params.init, buf)
+            check('Module', value, value2, False)
+
+        big_data = bytes(300) * 10
+        value = crc_table(params, params.init, big_data)
+        value2 = crc_clmul.crc_calc(module_params, module_params.init, big_data)
+        check('Module Big', value, value2, False)
+
+        xp = crc_clmul.crc_combine_constant(module_params, len(test_data[150:]))
+        value = crc_clmul.crc_table(module_params, module_params.init, test_data[:150])
+        value2 = crc_clmul.crc_calc(module_params, module_params.init, test_data[150:])
+        value3 = crc_clmul.crc_combine(module_params, value, value2, xp)
+        value4 = crc_table(params, params.init, test_data)
+        check('Module Combine', value3, value4, False)
+
     print()
 
+# Bitwise CRC of any width, to check the wide CRCs against
+def crc_reference(width, poly, init, refin, refout, xorout, data):
+    crc = init
+    top = 1 << (width - 1)
+    mask = (1 << width) - 1
+
+    for b in data:
+        if refin:
+            b = int(f'{b:08b}'[::-1], 2)
+
+        for i in range(7, -1, -1):
+            feedback = ((crc & top) != 0) ^ ((b >> i) & 1)
+            crc = (crc << 1) & mask
+
+            if feedback:
+                crc ^= poly
+
+    if refout:
+        crc = int(f'{crc:0{width}b}'[::-1], 2)
+
+    return crc ^ xorout
+
+# Made up models with parameters (width, poly, init, refin, refout, xorout) that
+# fill a part of the high half and all of it
+synthetic_models = {
+    'CRC96-TEST': (96, 0xc3a5965a0f0ff0f0a5a5c3c3, 0xffffffffffffffffffffffff, False, False, 0x0123456789abcdef01234567),
+    'CRC96-TEST-R': (96, 0xc3a5965a0f0ff0f0a5a5c3c3, 0x000000000000000000000001, True, True, 0xffffffffffffffffffffffff),
+    'CRC128-TEST': (128, 0x8000000000000000000000000000001b, 0, False, False, 0xffffffffffffffffffffffffffffffff),
+    'CRC128-TEST-R': (128, 0xe10000000000000000000000000000c3, 0xffffffffffffffffffffffffffffffff, True, False, 0),
+}
+
+for name, model in list(wide_models.items()) + list(synthetic_models.items()):
+    print(name)
+    check_value = crc_reference(*model[:6], b'123456789')
+    params128 = crc128_params(*model[:6], check_value)
+
+    if name in wide_models:
+        check('Check', check_value, model.check)
+
+    # Test crc128_table and crc128_calc with different lengths and alignments
+    for i in (0, 1, 15, 16, 17, 63, 64, 65, 100, 300, 1200):
+        value = crc_reference(*model[:6], long_data[3:i + 3])
+        value2 = crc128_table(params128, crc128_init(params128), long_data[3:i + 3])
+        value3 = crc128_calc(params128, crc128_init(params128), long_data[3:i + 3])
+        check('Table', value, value2, False)
+        check('Calc', value, value3, False)
+
+    # Test crc128_calc in chunks
+    value = crc128_calc(params128, crc128_init(params128), long_data[:150])
+    value = crc128_calc(params128, value, long_data[150:])
+    value2 = crc128_table(params128, crc128_init(params128), long_data)
+    check('Chunked', value, value2)
+
+    # Test crc128_combine
+    xp = crc128_combine_constant(params128, len(long_data[150:]))
+    value = crc128_calc(params128, crc128_init(params128), long_data[:150])
+    value2 = crc128_calc(params128, crc128_init(params128), long_data[150:])
+    value3 = crc128_combine(params128, value, value2, xp)
+    value4 = crc128_table(params128, crc128_init(params128), long_data)
+    check('Combine', value3, value4)
+
+    print()
+
+crc_pool_destroy(pool)
+os.remove(index_path)
+os.rmdir(os.path.dirname(index_path))
+crc_params_unmap(*image)
+os.remove(image_path)
+os.rmdir(os.path.dirname(image_path))
+
 if failed:
     raise Exception('Test failed')
 else:
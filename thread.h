@@ -0,0 +1,107 @@
+/* Defines equivalent macros for both Windows and POSIX threads. */
+
+#ifndef THREAD_H
+#define THREAD_H
+
+#ifdef _WIN32
+
+#include <windows.h>
+
+typedef SRWLOCK mutex_t;
+typedef CONDITION_VARIABLE cond_t;
+typedef HANDLE thread_t;
+
+//Return type of a thread's entry point.
+#define THREAD_FUNC DWORD WINAPI
+#define THREAD_RETURN 0
+
+//Static initializer for a mutex.
+#define MUTEX_INITIALIZER SRWLOCK_INIT
+
+#define mutex_init(m) InitializeSRWLock(m)
+#define mutex_destroy(m) ((void)(m))
+#define mutex_lock(m) AcquireSRWLockExclusive(m)
+#define mutex_unlock(m) ReleaseSRWLockExclusive(m)
+
+#define cond_init(c) InitializeConditionVariable(c)
+#define cond_destroy(c) ((void)(c))
+#define cond_wait(c, m) SleepConditionVariableSRW(c, m, INFINITE, 0)
+#define cond_signal(c) WakeConditionVariable(c)
+#define cond_broadcast(c) WakeAllConditionVariable(c)
+
+//Start a thread running f(arg). Evaluates to true on success.
+#define thread_create(t, f, arg) ((*(t) = CreateThread(NULL, 0, f, arg, 0, NULL)) != NULL)
+#define thread_join(t) (WaitForSingleObject(t, INFINITE), CloseHandle(t))
+#define thread_yield() SwitchToThread()
+
+//Atomic operations on 64-bit integers. xor and add return the previous value.
+#define atomic_xor64(p, v) ((uint64_t)InterlockedXor64((LONG64 volatile*)(p), (LONG64)(v)))
+#define atomic_add64(p, v) ((uint64_t)InterlockedExchangeAdd64((LONG64 volatile*)(p), (LONG64)(v)))
+#define atomic_load64(p) ((uint64_t)InterlockedOr64((LONG64 volatile*)(p), 0))
+#define atomic_store64(p, v) ((void)InterlockedExchange64((LONG64 volatile*)(p), (LONG64)(v)))
+
+//Atomic without ordering. Aligned 64-bit loads and stores are atomic on 64-bit Windows.
+#define atomic_load64_relaxed(p) ((uint64_t)*(LONG64 volatile*)(p))
+#define atomic_store64_relaxed(p, v) ((void)(*(LONG64 volatile*)(p) = (LONG64)(v)))
+
+//Number of logical processors.
+static inline unsigned int thread_cpu_count() {
+    SYSTEM_INFO info;
+    GetSystemInfo(&info);
+    return info.dwNumberOfProcessors;
+}
+
+//----------------------------------------
+
+#else
+
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+
+typedef pthread_mutex_t mutex_t;
+typedef pthread_cond_t cond_t;
+typedef pthread_t thread_t;
+
+//Return type of a thread's entry point.
+#define THREAD_FUNC void*
+#define THREAD_RETURN NULL
+
+//Static initializer for a mutex.
+#define MUTEX_INITIALIZER PTHREAD_MUTEX_INITIALIZER
+
+#define mutex_init(m) pthread_mutex_init(m, NULL)
+#define mutex_destroy(m) pthread_mutex_destroy(m)
+#define mutex_lock(m) pthread_mutex_lock(m)
+#define mutex_unlock(m) pthread_mutex_unlock(m)
+
+#define cond_init(c) pthread_cond_init(c, NULL)
+#define cond_destroy(c) pthread_cond_destroy(c)
+#define cond_wait(c, m) pthread_cond_wait(c, m)
+#define cond_signal(c) pthread_cond_signal(c)
+#define cond_broadcast(c) pthread_cond_broadcast(c)
+
+//Start a thread running f(arg). Evaluates to true on success.
+#define thread_create(t, f, arg) (pthread_create(t, NULL, f, arg) == 0)
+#define thread_join(t) pthread_join(t, NULL)
+#define thread_yield() sched_yield()
+
+//Atomic operations on 64-bit integers. xor and add return the previous value.
+#define atomic_xor64(p, v) __atomic_fetch_xor(p, v, __ATOMIC_SEQ_CST)
+#define atomic_add64(p, v) __atomic_fetch_add(p, v, __ATOMIC_SEQ_CST)
+#define atomic_load64(p) __atomic_load_n(p, __ATOMIC_SEQ_CST)
+#define atomic_store64(p, v) __atomic_store_n(p, v, __ATOMIC_SEQ_CST)
+
+//Atomic without ordering.
+#define atomic_load64_relaxed(p) __atomic_load_n(p, __ATOMIC_RELAXED)
+#define atomic_store64_relaxed(p, v) __atomic_store_n(p, v, __ATOMIC_RELAXED)
+
+//Number of logical processors.
+static inline unsigned int thread_cpu_count() {
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return n > 0 ? (unsigned int)n : 1;
+}
+
+#endif
+
+#endif
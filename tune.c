@@ -0,0 +1,237 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "tune.h"
+#include "thread.h"
+
+#ifndef DISABLE_SIMD
+#include "cpu.h"
+#endif
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#endif
+
+/* Number of bytes processed in each timed run. */
+#define TUNE_BYTES 32768
+
+/* Number of timed runs. The fastest run is used. */
+#define TUNE_RUNS 5
+
+/* First line of a tuning file. */
+#define TUNE_HEADER "crc-clmul tuning 2"
+
+//----------------------------------------
+
+/* Timing functions */
+
+#ifndef DISABLE_SIMD
+/* Returns a timestamp in seconds. */
+static double tune_now() {
+    #ifdef _WIN32
+    LARGE_INTEGER count, frequency;
+    QueryPerformanceCounter(&count);
+    QueryPerformanceFrequency(&frequency);
+    return (double)count.QuadPart / (double)frequency.QuadPart;
+    #else
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec + t.tv_nsec * 1e-9;
+    #endif
+}
+
+/* Prevents the compiler from removing the timed calls. */
+static volatile uint64_t tune_sink;
+
+/* Time crc_calc_tuned on a buffer with the lengths in tuning. Returns the time
+   per call in seconds. The CRC of each call is used by the next, so the latency of the
+   whole computation is measured. */
+static double tune_time(params_t *params, crc_tuning_t const *tuning, unsigned char const *buf, uint64_t len) {
+    uint64_t n = TUNE_BYTES / (len + 16) + 1;
+    uint64_t crc = params->init;
+    double best = 1e9;
+
+    for(uint8_t r = 0; r < TUNE_RUNS; r++) {
+        double start = tune_now();
+
+        for(uint64_t i = 0; i < n; i++) {
+            crc = crc_calc_tuned(params, tuning, crc, buf, len);
+        }
+
+        double t = tune_now() - start;
+        if(t < best) {
+            best = t;
+        }
+    }
+
+    tune_sink ^= crc;
+    return best / n;
+}
+#endif
+
+//----------------------------------------
+
+/* Autotuner */
+
+#ifndef DISABLE_SIMD
+/* Find the shortest of the lengths from which the second value of *field is
+   faster than the first for every longer length. field points into tuning, and
+   the other fields of tuning are left as they are. Returns 0 if the second value
+   never wins. The buffers of both CRC models are timed and added together. */
+static uint64_t tune_crossover(params_t *params, crc_tuning_t *tuning, unsigned char const *buf, uint64_t *field, uint64_t a, uint64_t b, const uint64_t *lengths, uint8_t n) {
+    uint64_t crossover = 0;
+
+    for(uint8_t i = n; i-- > 0;) {
+        double ta = 0, tb = 0;
+
+        for(uint8_t j = 0; j < 2; j++) {
+            *field = a;
+            ta += tune_time(&params[j], tuning, buf, lengths[i]);
+            *field = b;
+            tb += tune_time(&params[j], tuning, buf, lengths[i]);
+        }
+
+        if(tb >= ta) {
+            break;
+        }
+
+        crossover = lengths[i];
+    }
+
+    return crossover;
+}
+#endif
+
+/* Replace crc_tuning with tuning. Each field is stored atomically, since other
+   threads may be reading crc_tuning. */
+static void tune_publish(crc_tuning_t const *tuning) {
+    atomic_store64_relaxed(&crc_tuning.clmul_min, tuning->clmul_min);
+    atomic_store64_relaxed(&crc_tuning.align_min, tuning->align_min);
+    atomic_store64_relaxed(&crc_tuning.fold4_min, tuning->fold4_min);
+    atomic_store64_relaxed(&crc_tuning.shuffle_min, tuning->shuffle_min);
+}
+
+/* The tuning is measured with a reflected and a non-reflected model. Each
+   threshold is measured with the others set to their defaults. The lengths are
+   measured in a local crc_tuning_t, and crc_tuning is only written once at the
+   end. */
+void crc_autotune() {
+    #ifndef DISABLE_SIMD
+    cpu_check_features();
+
+    if(!cpu_enable_simd && !cpu_enable_shuffle) {
+        return;
+    }
+
+    static const uint64_t clmul_lengths[] = {16, 24, 32, 40, 48, 64, 80, 96, 128};
+    static const uint64_t fold4_lengths[] = {64, 80, 96, 112, 128, 160, 192, 256};
+    static const uint64_t align_lengths[] = {128, 256, 512, 1024, 2048, 4096, 8192, 16384};
+    static const uint64_t shuffle_lengths[] = {64, 128, 256, 384, 512, 1024, 2048, 4096};
+
+    const crc_tuning_t defaults = {16, 512, 48, 1024};
+    crc_tuning_t tuned = defaults;
+    params_t params[2];
+    uint8_t error;
+
+    params[0] = crc_params(32, 0x04c11db7, 0xffffffff, true, true, 0xffffffff, 0xcbf43926, &error);
+    params[1] = crc_params(32, 0x04c11db7, 0xffffffff, false, false, 0x00000000, 0x0376e6e7, &error);
+
+    //Leave room to align the buffer and to time it unaligned.
+    unsigned char *data = (unsigned char*) malloc(16384 + 16);
+
+    if(data == NULL) {
+        return;
+    }
+
+    for(uint64_t i = 0; i < 16384 + 16; i++) {
+        data[i] = (unsigned char)(i * 31 + 7);
+    }
+
+    unsigned char *aligned = data + (16 - ((uintptr_t)data & 0xf)) % 16;
+
+    crc_tuning_t trial;
+
+    //Table-based algorithm against the shuffle algorithm, with CLMUL disabled
+    //since it's preferred when available.
+    if(cpu_enable_shuffle) {
+        trial = defaults;
+        trial.clmul_min = UINT64_MAX;
+        uint64_t shuffle_min = tune_crossover(params, &trial, aligned, &trial.shuffle_min, UINT64_MAX, 0, shuffle_lengths, sizeof(shuffle_lengths) / sizeof(uint64_t));
+        tuned.shuffle_min = shuffle_min ? shuffle_min : UINT64_MAX;
+    }
+
+    if(!cpu_enable_simd) {
+        tune_publish(&tuned);
+        free(data);
+        return;
+    }
+
+    //Table-based algorithm against the SIMD algorithm.
+    trial = defaults;
+    uint64_t clmul_min = tune_crossover(params, &trial, aligned, &trial.clmul_min, UINT64_MAX, 16, clmul_lengths, sizeof(clmul_lengths) / sizeof(uint64_t));
+    tuned.clmul_min = clmul_min ? clmul_min : 128;
+
+    //Folding by 1 against folding by 4. The threshold excludes the first block.
+    trial = defaults;
+    uint64_t fold4_min = tune_crossover(params, &trial, aligned, &trial.fold4_min, UINT64_MAX, 48, fold4_lengths, sizeof(fold4_lengths) / sizeof(uint64_t));
+    tuned.fold4_min = fold4_min ? fold4_min - 16 : 256;
+    tuned.fold4_min = tuned.fold4_min < 48 ? 48 : tuned.fold4_min;
+
+    //Unaligned loads against aligning the buffer first.
+    trial = defaults;
+    uint64_t align_min = tune_crossover(params, &trial, aligned + 1, &trial.align_min, UINT64_MAX, 0, align_lengths, sizeof(align_lengths) / sizeof(uint64_t));
+    tuned.align_min = align_min ? align_min : UINT64_MAX;
+
+    tune_publish(&tuned);
+    free(data);
+    #endif
+}
+
+//----------------------------------------
+
+/* Tuning files */
+
+bool crc_tuning_save(const char *path) {
+    FILE *file = fopen(path, "w");
+
+    if(file == NULL) {
+        return false;
+    }
+
+    fprintf(file, TUNE_HEADER "\n");
+    fprintf(file, "clmul_min %llu\n", (unsigned long long) crc_tuning.clmul_min);
+    fprintf(file, "align_min %llu\n", (unsigned long long) crc_tuning.align_min);
+    fprintf(file, "fold4_min %llu\n", (unsigned long long) crc_tuning.fold4_min);
+    fprintf(file, "shuffle_min %llu\n", (unsigned long long) crc_tuning.shuffle_min);
+
+    return fclose(file) == 0;
+}
+
+bool crc_tuning_load(const char *path) {
+    FILE *file = fopen(path, "r");
+
+    if(file == NULL) {
+        return false;
+    }
+
+    char line[64];
+    unsigned long long clmul_min, align_min, fold4_min, shuffle_min;
+    bool valid = fgets(line, sizeof(line), file) != NULL &&
+                 strncmp(line, TUNE_HEADER "\n", sizeof(TUNE_HEADER)) == 0 &&
+                 fscanf(file, " clmul_min %llu", &clmul_min) == 1 &&
+                 fscanf(file, " align_min %llu", &align_min) == 1 &&
+                 fscanf(file, " fold4_min %llu", &fold4_min) == 1 &&
+                 fscanf(file, " shuffle_min %llu", &shuffle_min) == 1 &&
+                 clmul_min >= 16 && fold4_min >= 48;
+
+    fclose(file);
+
+    if(valid) {
+        crc_tuning_t tuning = {clmul_min, align_min, fold4_min, shuffle_min};
+        tune_publish(&tuning);
+    }
+
+    return valid;
+}
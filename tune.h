@@ -0,0 +1,20 @@
+#ifndef CRC_TUNE_H
+#define CRC_TUNE_H
+
+#include "crc.h"
+
+/* Measure the table-based and SIMD algorithms on this CPU and store the lengths
+   at which crc_calc should switch between them in crc_tuning. Takes a few
+   milliseconds. crc_tuning is only replaced once the measurements are done, so
+   it's safe to call while other threads compute CRCs. Does nothing when SIMD
+   intrinsics aren't available. */
+void DLL_EXPORT crc_autotune();
+
+/* Write crc_tuning to a small text file. Returns false on failure. */
+bool DLL_EXPORT crc_tuning_save(const char *path);
+
+/* Read crc_tuning from a file written by crc_tuning_save. crc_tuning is left
+   unchanged and false is returned if the file is missing or invalid. */
+bool DLL_EXPORT crc_tuning_load(const char *path);
+
+#endif